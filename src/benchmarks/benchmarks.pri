@@ -0,0 +1,11 @@
+# QtTest benchmarks over the classes of the table view, run e.g.
+#   ./tst_bench_tablemodel -o result.xml,xml
+# table sizes are set by TABLEVIEW_BENCH_ROWS, see shared/benchdata.h
+include(../tableview/tableview.pri)
+
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/shared
+HEADERS += $$PWD/shared/benchdata.h
@@ -0,0 +1,121 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename main.cpp
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonDocument>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QTimer>
+
+#include "benchdata.h"
+#include "qmltypes.h"
+#include "scrollbenchmark.h"
+#include "sql.h"
+
+// a run that does not finish in time has stalled
+static const int Timeout = 10 * 60 * 1000;
+
+static void setDefault(const char *name, const QByteArray &value)
+{
+    if(!qEnvironmentVariableIsSet(name))
+        qputenv(name, value);
+}
+
+int main(int argc, char *argv[])
+{
+    // no display needed, frames are swapped on the GUI thread
+    setDefault("QT_QPA_PLATFORM", "offscreen");
+    setDefault("QT_QUICK_BACKEND", "software");
+    setDefault("QSG_RENDER_LOOP", "basic");
+
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Scrolls the TableView of a QML file through a generated books table.");
+    parser.addHelpOption();
+    const QCommandLineOption qmlOption("qml", "The QML file to load.", "url", "qrc:/main.qml");
+    const QCommandLineOption rowsOption("rows", "Rows of the books table.", "rows", "100000");
+    const QCommandLineOption stepsOption("steps", "Frames of the scroll through.", "frames", "1000");
+    const QCommandLineOption resizesOption("resizes", "Frames with a changed window width.", "frames", "40");
+    const QCommandLineOption outputOption("output", "JSON result file, stdout by default.", "file");
+    parser.addOptions({ qmlOption, rowsOption, stepsOption, resizesOption, outputOption });
+    parser.process(app);
+
+    QmlTypes::registerTypes();
+
+    // the default table of the models, filled before the QML is loaded
+    QSqlDatabase db = Sql::memoryDatabase();
+    if(!BenchData::generate(db, parser.value(rowsOption).toInt()))
+    {
+        qWarning() << "Can not generate the books table" << db.lastError().text();
+        return 1;
+    }
+
+    QQmlApplicationEngine engine;
+    engine.load(QUrl::fromUserInput(parser.value(qmlOption)));
+    QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().value(0));
+    QQuickItem *tableView = window ? window->findChild<QQuickItem *>("tableView") : nullptr;
+    if(!tableView)
+    {
+        qWarning() << "No window with a TableView of objectName \"tableView\" in" << parser.value(qmlOption);
+        return 1;
+    }
+
+    ScrollBenchmark::Options options;
+    options.steps = parser.value(stepsOption).toInt();
+    options.resizes = parser.value(resizesOption).toInt();
+    ScrollBenchmark benchmark(window, tableView, options);
+    engine.rootContext()->setContextProperty("benchProbe", &benchmark);
+
+    QObject::connect(&benchmark, &ScrollBenchmark::finished, &app, [&](const QJsonObject &result) {
+        const QByteArray json = QJsonDocument(result).toJson();
+        QFile file;
+        const bool ok = parser.isSet(outputOption)
+                ? (file.setFileName(parser.value(outputOption)), file.open(QIODevice::WriteOnly))
+                : file.open(stdout, QIODevice::WriteOnly);
+        if(ok)
+            file.write(json);
+        app.exit(ok ? 0 : 1);
+    });
+
+    // started once the rows are counted, the model loads asynchronously
+    QTimer ready;
+    QObject::connect(&ready, &QTimer::timeout, &app, [&]() {
+        if(tableView->property("rows").toInt() <= 0)
+            return;
+        ready.stop();
+        benchmark.start();
+    });
+    ready.start(10);
+
+    QTimer::singleShot(Timeout, &app, [&app]() {
+        qWarning() << "Scroll benchmark timed out";
+        app.exit(1);
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,13 @@
+include(../benchmarks.pri)
+
+TARGET = bench_qmlscroll
+
+SOURCES += \
+    main.cpp \
+    scrollbenchmark.cpp
+
+HEADERS += \
+    scrollbenchmark.h
+
+# main.qml of the application
+RESOURCES += ../../tableview/qml.qrc
@@ -0,0 +1,242 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename scrollbenchmark.cpp
+ * @class ScrollBenchmark
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "scrollbenchmark.h"
+#include "tablemodel.h"
+
+#include <QJsonArray>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQmlExpression>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <algorithm>
+
+// the width by which the window grows in the resize phase
+static const int ResizeWidth = 200;
+
+ScrollBenchmark::ScrollBenchmark(QQuickWindow *window, QQuickItem *tableView, const Options &options)
+    : m_window(window)
+    , m_tableView(tableView)
+    , m_options(options)
+{
+
+}
+
+void ScrollBenchmark::start()
+{
+    // every evaluation of a provider goes through benchProbe.count()
+    QQmlExpression wrap(qmlContext(m_tableView), m_tableView, QStringLiteral(
+        "(function () {"
+        "  var width = columnWidthProvider, height = rowHeightProvider;"
+        "  if (typeof width === 'function')"
+        "    columnWidthProvider = function (column) { benchProbe.count('columnWidthProvider'); return width(column); };"
+        "  if (typeof height === 'function')"
+        "    rowHeightProvider = function (row) { benchProbe.count('rowHeightProvider'); return height(row); };"
+        "})()"));
+    wrap.evaluate();
+    if(wrap.hasError())
+        qWarning() << "Can not count the providers" << wrap.error().toString();
+
+    // the table and the header views, by the visual tree
+    QList<QQuickItem *> items = m_window->contentItem()->childItems();
+    while (!items.isEmpty())
+    {
+        QQuickItem *item = items.takeFirst();
+        if(item->inherits("QQuickFlickable"))
+        {
+            const QString name = item->objectName().isEmpty()
+                    ? QString("%1#%2").arg(item->metaObject()->className()).arg(m_viewItems.count())
+                    : item->objectName();
+            m_viewItems.append(qMakePair(name, QPointer<QQuickItem>(item)));
+        }
+        items += item->childItems();
+    }
+
+    m_baseWidth = m_window->width();
+    connect(m_window, &QQuickWindow::frameSwapped, this, &ScrollBenchmark::onFrameSwapped);
+    m_timer.start();
+    advance();
+}
+
+void ScrollBenchmark::count(const QString &name)
+{
+    ++m_counts[name];
+}
+
+void ScrollBenchmark::onFrameSwapped()
+{
+    if(m_phase == Done)
+        return;
+
+    // the frame shown was started by the last step of this phase
+    const qint64 time = m_timer.nsecsElapsed();
+    if(m_lastFrame >= 0)
+        m_frames[m_phase].append(time - m_lastFrame);
+    m_lastFrame = time;
+
+    scanDelegates();
+    advance();
+}
+
+void ScrollBenchmark::advance()
+{
+    if(m_phase == Scroll)
+    {
+        const qreal range = qMax<qreal>(0, m_tableView->property("contentHeight").toReal() - m_tableView->height());
+        if(m_step <= m_options.steps)
+        {
+            m_tableView->setProperty("contentY", range * m_step / qMax(1, m_options.steps));
+            ++m_step;
+            m_window->update();
+            return;
+        }
+
+        m_phase = Resize;
+        m_step = 0;
+        m_lastFrame = -1;
+    }
+
+    if(m_phase == Resize)
+    {
+        // every width change spreads the view width over the columns again
+        if(m_step < m_options.resizes)
+        {
+            m_window->setWidth(m_baseWidth + (m_step % 2 == 0 ? ResizeWidth : 0));
+            ++m_step;
+            m_window->update();
+            return;
+        }
+
+        m_phase = Done;
+        m_window->setWidth(m_baseWidth);
+        const QJsonObject json = result();
+        QMetaObject::invokeMethod(this, [this, json]() {
+            emit finished(json);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ScrollBenchmark::scanDelegates()
+{
+    for (const QPair<QString, QPointer<QQuickItem> > &view : m_viewItems)
+    {
+        if(!view.second)
+            continue;
+
+        QQuickItem *content = view.second->property("contentItem").value<QQuickItem *>();
+        if(!content)
+            continue;
+
+        ViewStats &stats = m_views[view.first];
+        for (QQuickItem *item : content->childItems())
+        {
+            // pooled delegates are hidden
+            QQmlContext *context = qmlContext(item);
+            if(!item->isVisible() || !context)
+                continue;
+
+            const QVariant row = context->contextProperty(QStringLiteral("row"));
+            const QVariant index = context->contextProperty(QStringLiteral("index"));
+            QString cell;
+            if(row.isValid())
+                cell = row.toString() + "," + context->contextProperty(QStringLiteral("column")).toString();
+            else if(index.isValid())
+                cell = index.toString();
+            else
+                continue;
+
+            QHash<QQuickItem *, QString>::iterator it = stats.cells.find(item);
+            if(it == stats.cells.end())
+            {
+                ++stats.created;
+                stats.cells.insert(item, cell);
+                const QString name = view.first;
+                connect(item, &QObject::destroyed, this, [this, name, item]() {
+                    m_views[name].cells.remove(item);
+                });
+            }
+            else if(it.value() != cell)
+            {
+                ++stats.reused;
+                it.value() = cell;
+            }
+        }
+    }
+}
+
+QJsonObject ScrollBenchmark::result() const
+{
+    QJsonObject json;
+    json.insert(QStringLiteral("steps"), m_options.steps);
+    json.insert(QStringLiteral("resizes"), m_options.resizes);
+    json.insert(QStringLiteral("rows"), m_tableView->property("rows").toInt());
+    json.insert(QStringLiteral("scroll"), percentiles(m_frames[Scroll]));
+    json.insert(QStringLiteral("resize"), percentiles(m_frames[Resize]));
+
+    QJsonObject views;
+    for (QHash<QString, ViewStats>::const_iterator it = m_views.constBegin(); it != m_views.constEnd(); ++it)
+    {
+        QJsonObject stats;
+        stats.insert(QStringLiteral("created"), it->created);
+        stats.insert(QStringLiteral("reused"), it->reused);
+        views.insert(it.key(), stats);
+    }
+    json.insert(QStringLiteral("delegates"), views);
+
+    QJsonObject counts;
+    for (QHash<QString, qint64>::const_iterator it = m_counts.constBegin(); it != m_counts.constEnd(); ++it)
+        counts.insert(it.key(), it.value());
+    json.insert(QStringLiteral("bindings"), counts);
+
+    // data() calls, cache and queries of the model behind the table
+    if(TableModel *model = qobject_cast<TableModel *>(m_tableView->property("model").value<QObject *>()))
+        json.insert(QStringLiteral("model"), QJsonObject::fromVariantMap(model->metrics()->snapshot()));
+
+    return json;
+}
+
+QJsonObject ScrollBenchmark::percentiles(QVector<qint64> frames)
+{
+    QJsonObject json;
+    json.insert(QStringLiteral("frames"), frames.count());
+    if(frames.isEmpty())
+        return json;
+
+    // ms
+    std::sort(frames.begin(), frames.end());
+    auto at = [&frames](qreal p) {
+        return frames.at(qMin(frames.count() - 1, int(p * frames.count()))) / 1e6;
+    };
+    qint64 total = 0;
+    for (qint64 frame : frames)
+        total += frame;
+
+    json.insert(QStringLiteral("mean"), total / 1e6 / frames.count());
+    json.insert(QStringLiteral("p50"), at(0.50));
+    json.insert(QStringLiteral("p90"), at(0.90));
+    json.insert(QStringLiteral("p99"), at(0.99));
+    json.insert(QStringLiteral("max"), frames.last() / 1e6);
+    return json;
+}
@@ -0,0 +1,102 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename scrollbenchmark.h
+ * @class ScrollBenchmark
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef SCROLLBENCHMARK_H
+#define SCROLLBENCHMARK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QPair>
+#include <QPointer>
+#include <QVector>
+
+class QQuickItem;
+class QQuickWindow;
+
+/**
+ * Scrolls the TableView of a loaded window through all of its rows, one
+ * step per frame, then resizes the window back and forth.
+ *
+ * Every frame the delegates of all views (the table and the header list
+ * views) are looked at: an item not seen before was created, an item seen
+ * at another cell before was reused. The row height and column width
+ * providers of the table are wrapped to count their evaluations. The
+ * result is a JSON object with the frame time percentiles of both phases.
+ */
+class ScrollBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options
+    {
+        int steps = 1000;       // frames of the scroll through
+        int resizes = 40;       // frames with a changed window width
+    };
+
+    ScrollBenchmark(QQuickWindow *window, QQuickItem *tableView, const Options &options);
+
+    void start();
+
+    Q_INVOKABLE void count(const QString &name);
+
+signals:
+    void finished(const QJsonObject &result);
+
+private:
+    enum Phase {
+        Scroll = 0,
+        Resize,
+        Done
+    };
+
+    struct ViewStats
+    {
+        QHash<QQuickItem *, QString> cells;
+        int created = 0;
+        int reused = 0;
+    };
+
+    void onFrameSwapped();
+    void advance();
+    void scanDelegates();
+    QJsonObject result() const;
+    static QJsonObject percentiles(QVector<qint64> frames);
+
+    QPointer<QQuickWindow> m_window;
+    QPointer<QQuickItem> m_tableView;
+    Options m_options;
+    Phase m_phase = Scroll;
+    int m_step = 0;
+    int m_baseWidth = 0;
+
+    QElapsedTimer m_timer;
+    qint64 m_lastFrame = -1;
+    QVector<qint64> m_frames[Done];     // ns by phase
+    QVector<QPair<QString, QPointer<QQuickItem> > > m_viewItems;
+    QHash<QString, ViewStats> m_views;
+    QHash<QString, qint64> m_counts;
+};
+
+#endif // SCROLLBENCHMARK_H
@@ -0,0 +1,161 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename benchdata.h
+ * @class BenchData
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef BENCHDATA_H
+#define BENCHDATA_H
+
+#include "migration.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTest>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+/**
+ * Synthetic books tables for the benchmarks.
+ *
+ * A table of every size is generated once into the temp directory from
+ * the schema of the migrations and used again by later runs. The sizes are
+ * read from TABLEVIEW_BENCH_ROWS, e.g. "10000,1000000,10000000".
+ */
+class BenchData
+{
+public:
+    static QList<int> sizes()
+    {
+        QList<int> rows;
+        const QString sizes = qEnvironmentVariable("TABLEVIEW_BENCH_ROWS", QStringLiteral("10000,1000000"));
+        for (const QString &size : sizes.split(QLatin1Char(','), QString::SkipEmptyParts))
+        {
+            bool ok = false;
+            const int count = size.trimmed().toInt(&ok);
+            if(ok && count > 0)
+                rows << count;
+        }
+
+        return rows;
+    }
+
+    // 10k, 1M, 10M
+    static QByteArray tag(int rows)
+    {
+        if(rows >= 1000000 && rows % 1000000 == 0)
+            return QByteArray::number(rows / 1000000) + "M";
+        if(rows >= 1000 && rows % 1000 == 0)
+            return QByteArray::number(rows / 1000) + "k";
+        return QByteArray::number(rows);
+    }
+
+    static void addSizes()
+    {
+        QTest::addColumn<int>("rows");
+        for (int rows : sizes())
+            QTest::newRow(tag(rows).constData()) << rows;
+    }
+
+    // the file of a books table with rows rows
+    static QString database(int rows)
+    {
+        const QString fileName = QDir::temp().filePath(QString("tableview-bench-%1.db").arg(rows));
+        const QString connection = QStringLiteral("bench-data");
+        bool ok = true;
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connection);
+            db.setDatabaseName(fileName);
+            ok = db.open();
+            if(ok && count(db) != rows)
+            {
+                qInfo() << "generate" << rows << "books into" << fileName;
+                db.close();
+                QFile::remove(fileName);
+                ok = db.open() && Migration(db).run(QStringLiteral(":/migrations")) && generate(db, rows);
+            }
+
+            if(!ok)
+                qWarning() << "Can not generate" << fileName << db.lastError().text();
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connection);
+
+        return ok ? fileName : QString();
+    }
+
+    // ids from 1 to rows, few distinct authors and publishers
+    static bool generate(QSqlDatabase db, int rows)
+    {
+        QSqlQuery query(db);
+        if(!db.transaction() || !query.exec("DELETE FROM books"))
+            return false;
+
+        query.prepare("INSERT INTO books (id, title, isdn, author, publisher, time, page, price, "
+                      "description, rating, state) "
+                      "WITH RECURSIVE seq(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM seq WHERE x < ?) "
+                      "SELECT x, 'Book ' || x, printf('978%010d', x), 'Author ' || (x % 997), "
+                      "'Publisher ' || (x % 31), date('2000-01-01', '+' || (x % 7300) || ' days'), "
+                      "100 + x % 900, 1000 + x % 9000, 'Description of book ' || x, 1 + x % 5, 0 FROM seq");
+        query.addBindValue(rows);
+        if(!query.exec())
+        {
+            qWarning() << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+
+        return db.commit();
+    }
+
+    static int count(QSqlDatabase db)
+    {
+        QSqlQuery query(db);
+        if(!query.exec("SELECT COUNT(*) FROM books") || !query.next())
+            return -1;
+
+        return query.value(0).toInt();
+    }
+
+    // peak resident set size of the process in bytes, 0 if unknown
+    static qint64 peakMemory()
+    {
+#ifdef Q_OS_UNIX
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#  ifdef Q_OS_DARWIN
+        return usage.ru_maxrss;
+#  else
+        return qint64(usage.ru_maxrss) * 1024;
+#  endif
+#else
+        return 0;
+#endif
+    }
+};
+
+#endif // BENCHDATA_H
@@ -0,0 +1,6 @@
+include(../benchmarks.pri)
+
+TARGET = tst_bench_sql
+
+SOURCES += \
+    tst_bench_sql.cpp
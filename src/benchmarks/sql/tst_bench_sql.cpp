@@ -0,0 +1,124 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename tst_bench_sql.cpp
+ * @class tst_Bench_Sql
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "benchdata.h"
+#include "migration.h"
+#include "sql.h"
+#include "tablemodel.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+// an import of 10M rows takes minutes
+static const int ImportTimeout = 30 * 60 * 1000;
+
+class tst_Bench_Sql : public QObject
+{
+    Q_OBJECT
+private slots:
+    void migration();
+    void bulkInsert_data();
+    void bulkInsert();
+    void peakMemory();
+};
+
+void tst_Bench_Sql::migration()
+{
+    // every run on a new, empty database
+    int run = 0;
+    QBENCHMARK {
+        const QString connection = QString("bench-migration-%1").arg(++run);
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connection);
+            db.setDatabaseName(QStringLiteral(":memory:"));
+            QVERIFY(db.open());
+            QVERIFY(Migration(db).run(QStringLiteral(":/migrations")));
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connection);
+    }
+}
+
+void tst_Bench_Sql::bulkInsert_data()
+{
+    BenchData::addSizes();
+}
+
+void tst_Bench_Sql::bulkInsert()
+{
+    QFETCH(int, rows);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // a CSV file with the columns of the books table
+    const QString csv = dir.filePath(QStringLiteral("books.csv"));
+    {
+        QFile file(csv);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QByteArray buffer = "title,isdn,author,publisher,time,page,price,rating\r\n";
+        for (int i = 1; i <= rows; ++i)
+        {
+            buffer += "Book " + QByteArray::number(i) + ",978" + QByteArray::number(i).rightJustified(10, '0')
+                    + ",Author " + QByteArray::number(i % 997) + ",Publisher " + QByteArray::number(i % 31)
+                    + ",2000-01-01," + QByteArray::number(100 + i % 900) + "," + QByteArray::number(1000 + i % 9000)
+                    + "," + QByteArray::number(1 + i % 5) + "\r\n";
+            if(buffer.size() > 1024 * 1024)
+            {
+                file.write(buffer);
+                buffer.clear();
+            }
+        }
+        file.write(buffer);
+    }
+
+    // an empty books table of the migration schema
+    const QString fileName = dir.filePath(QStringLiteral("import.db"));
+    QSqlDatabase db = Sql::database(fileName);
+    QVERIFY(Migration(db).run(QStringLiteral(":/migrations")));
+    QVERIFY(QSqlQuery(db).exec(QStringLiteral("DELETE FROM books")));
+
+    TableModel model;
+    model.classBegin();
+    model.setDatabaseName(fileName);
+    model.setTable(QStringLiteral("books"));
+    model.componentComplete();
+
+    QSignalSpy finished(&model, &TableModel::importFinished);
+    QBENCHMARK_ONCE {
+        QVERIFY(model.importFile(QUrl::fromLocalFile(csv)));
+        QVERIFY(finished.wait(ImportTimeout));
+    }
+
+    QCOMPARE(finished.first().at(0).toBool(), true);
+    QCOMPARE(finished.first().at(1).toLongLong(), qint64(rows));
+}
+
+void tst_Bench_Sql::peakMemory()
+{
+    QTest::setBenchmarkResult(BenchData::peakMemory(), QTest::BytesAllocated);
+}
+
+QTEST_MAIN(tst_Bench_Sql)
+
+#include "tst_bench_sql.moc"
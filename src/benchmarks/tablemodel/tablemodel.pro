@@ -0,0 +1,6 @@
+include(../benchmarks.pri)
+
+TARGET = tst_bench_tablemodel
+
+SOURCES += \
+    tst_bench_tablemodel.cpp
@@ -0,0 +1,188 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename tst_bench_tablemodel.cpp
+ * @class tst_Bench_TableModel
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "benchdata.h"
+#include "sql.h"
+#include "tablemodel.h"
+
+#include <QtTest>
+
+// rows read by one scroll through, a whole 10M table takes too long
+static const int ScrollRows = 200000;
+
+static void open(TableModel *model, const QString &fileName, TableModel::FetchMode mode)
+{
+    model->classBegin();
+    model->setFetchMode(mode);
+    model->setDatabaseName(fileName);
+    model->setTable(QStringLiteral("books"));
+    model->componentComplete();
+}
+
+class tst_Bench_TableModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void select_data();
+    void select();
+    void data_data();
+    void data();
+    void scroll_data();
+    void scroll();
+    void removeSelected_data();
+    void removeSelected();
+    void peakMemory();
+};
+
+void tst_Bench_TableModel::select_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("mode");
+    for (int rows : BenchData::sizes())
+    {
+        QTest::newRow((BenchData::tag(rows) + ":cached").constData()) << rows << int(TableModel::CachedFetch);
+        QTest::newRow((BenchData::tag(rows) + ":windowed").constData()) << rows << int(TableModel::WindowedFetch);
+    }
+}
+
+void tst_Bench_TableModel::select()
+{
+    QFETCH(int, rows);
+    QFETCH(int, mode);
+    const QString fileName = BenchData::database(rows);
+    QVERIFY(!fileName.isEmpty());
+
+    TableModel model;
+    open(&model, fileName, TableModel::FetchMode(mode));
+    QVERIFY(model.rowCount() > 0);
+
+    QBENCHMARK {
+        model.select();
+    }
+}
+
+void tst_Bench_TableModel::data_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<QByteArray>("role");
+    for (int rows : BenchData::sizes())
+    {
+        for (const char *role : { "display", "title", "checkState", "itemStatus" })
+            QTest::newRow((BenchData::tag(rows) + ":" + role).constData()) << rows << QByteArray(role);
+    }
+}
+
+void tst_Bench_TableModel::data()
+{
+    QFETCH(int, rows);
+    QFETCH(QByteArray, role);
+    const QString fileName = BenchData::database(rows);
+    QVERIFY(!fileName.isEmpty());
+
+    TableModel model;
+    open(&model, fileName, TableModel::WindowedFetch);
+    const int roleId = model.roleNames().key(role, -1);
+    QVERIFY(roleId >= 0);
+
+    // the first page is in the cache, only data() itself is measured
+    const int count = qMin(model.rowCount(), model.pageSize());
+    const int columns = model.columnCount();
+    model.data(model.index(0, 0));
+
+    QBENCHMARK {
+        for (int row = 0; row < count; ++row)
+        {
+            for (int column = 0; column < columns; ++column)
+                model.data(model.index(row, column), roleId);
+        }
+    }
+}
+
+void tst_Bench_TableModel::scroll_data()
+{
+    BenchData::addSizes();
+}
+
+void tst_Bench_TableModel::scroll()
+{
+    QFETCH(int, rows);
+    const QString fileName = BenchData::database(rows);
+    QVERIFY(!fileName.isEmpty());
+
+    TableModel model;
+    open(&model, fileName, TableModel::WindowedFetch);
+
+    // every page is read from the database once
+    const int count = qMin(model.rowCount(), ScrollRows);
+    QBENCHMARK {
+        model.refresh();
+        for (int row = 0; row < count; ++row)
+            model.data(model.index(row, 1));
+    }
+}
+
+void tst_Bench_TableModel::removeSelected_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("count");
+    for (int rows : BenchData::sizes())
+    {
+        for (int count : { 100, 10000 })
+        {
+            if(count <= rows)
+                QTest::newRow((BenchData::tag(rows) + ":" + BenchData::tag(count)).constData()) << rows << count;
+        }
+    }
+}
+
+void tst_Bench_TableModel::removeSelected()
+{
+    QFETCH(int, rows);
+    QFETCH(int, count);
+    const QString fileName = BenchData::database(rows);
+    QVERIFY(!fileName.isEmpty());
+
+    TableModel model;
+    open(&model, fileName, TableModel::WindowedFetch);
+    model.selectRange(0, count - 1);
+
+    int removed = 0;
+    QBENCHMARK_ONCE {
+        removed = model.removeSelected();
+    }
+    QCOMPARE(removed, count);
+
+    // books delete softly, the rows come back for the next run
+    QSqlQuery query(model.database());
+    QVERIFY(query.exec("UPDATE books SET deleted_at = NULL WHERE deleted_at IS NOT NULL"));
+}
+
+void tst_Bench_TableModel::peakMemory()
+{
+    QTest::setBenchmarkResult(BenchData::peakMemory(), QTest::BytesAllocated);
+}
+
+QTEST_MAIN(tst_Bench_TableModel)
+
+#include "tst_bench_tablemodel.moc"
@@ -0,0 +1,759 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename aggregatemodel.cpp
+ * @class AggregateModel
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "aggregatemodel.h"
+#include "schemacache.h"
+#include "sql.h"
+#include "tablemodel.h"
+
+#include <QLoggingCategory>
+#include <QRegularExpression>
+#include <QSqlDriver>
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(lcAggregateModel, "app.AggregateModel")
+
+// groups, or written rows, aggregated again by one select, more select all
+// of them; the keys are bound twice, below SQLITE_MAX_VARIABLE_NUMBER 999
+static const int MaxGroups = 256;
+
+static const int GroupRole = Qt::UserRole + 1;
+
+// the collating sequences of SQLite, groups of any other one are not
+// ordered here
+enum Collation {
+    BinaryCollation = 0,
+    NoCaseCollation,
+    RTrimCollation,
+    OtherCollation
+};
+
+// the order of SQLite: NULL, numbers, text, blobs
+static int typeRank(const QVariant &value)
+{
+    if(value.isNull())
+        return 0;
+
+    switch (value.type())
+    {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+        return 1;
+    case QVariant::ByteArray:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+// text as the collating sequence of SQLite compares it, UTF-8 bytes
+// with ASCII letters folded for NOCASE and trailing spaces cut for RTRIM
+static QByteArray collationKey(const QVariant &value, int collation)
+{
+    QByteArray text = value.toString().toUtf8();
+    if(collation == NoCaseCollation)
+    {
+        for (int i = 0; i < text.size(); ++i)
+        {
+            if(text.at(i) >= 'A' && text.at(i) <= 'Z')
+                text[i] = char(text.at(i) + ('a' - 'A'));
+        }
+    }
+    else if(collation == RTrimCollation)
+    {
+        while (text.endsWith(' '))
+            text.chop(1);
+    }
+    return text;
+}
+
+static bool lessThan(const QVariant &left, const QVariant &right, int collation)
+{
+    const int rank = typeRank(left);
+    if(rank != typeRank(right))
+        return rank < typeRank(right);
+
+    switch (rank)
+    {
+    case 0:
+        return false;
+    case 1:
+        // integers exactly, a real against either as a double
+        if(left.type() != QVariant::Double && right.type() != QVariant::Double)
+            return left.toLongLong() < right.toLongLong();
+        return left.toDouble() < right.toDouble();
+    case 3:
+        return left.toByteArray() < right.toByteArray();
+    default:
+        return collationKey(left, collation) < collationKey(right, collation);
+    }
+}
+
+static bool same(const QVariant &left, const QVariant &right, int collation)
+{
+    return !lessThan(left, right, collation) && !lessThan(right, left, collation);
+}
+
+AggregateModel::AggregateModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_aggregates(QStringList() << "count")
+{
+
+}
+
+AggregateModel::~AggregateModel()
+{
+    if(m_feed)
+        m_feed->untrack(m_feedTable);
+}
+
+void AggregateModel::classBegin()
+{
+
+}
+
+void AggregateModel::componentComplete()
+{
+    m_completed = true;
+    refresh();
+}
+
+int AggregateModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_groups.count();
+}
+
+QVariant AggregateModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_groups.count())
+        return QVariant();
+
+    const Group &group = m_groups.at(index.row());
+    if(role == GroupRole || role == Qt::DisplayRole)
+        return group.value;
+
+    return group.values.value(role - GroupRole - 1);
+}
+
+QHash<int, QByteArray> AggregateModel::roleNames() const
+{
+    return m_roles;
+}
+
+QVariantMap AggregateModel::get(int row) const
+{
+    QVariantMap map;
+    const QModelIndex modelIndex = index(row);
+    for (QHash<int, QByteArray>::const_iterator it = m_roles.constBegin(); it != m_roles.constEnd(); ++it)
+        map.insert(QString::fromLatin1(it.value()), data(modelIndex, it.key()));
+
+    return map;
+}
+
+void AggregateModel::setSource(TableModel *model)
+{
+    if(m_source == model)
+        return;
+
+    if(m_source)
+        disconnect(m_source, nullptr, this, nullptr);
+
+    m_source = model;
+    m_before.clear();
+    m_beforeUnknown = false;
+    if(m_source)
+    {
+        connect(m_source, &TableModel::rowsAboutToBeWritten, this, &AggregateModel::rowsAboutToBeWritten);
+        connect(m_source, &TableModel::rowsWritten, this, &AggregateModel::rowsWritten);
+        connect(m_source, &TableModel::databaseNameChanged, this, [this]() {
+            if(m_databaseName.isEmpty())
+                refreshLater();
+        });
+        connect(m_source, &TableModel::readOnlyChanged, this, [this]() {
+            if(m_databaseName.isEmpty())
+                refreshLater();
+        });
+        connect(m_source, &TableModel::tableChanged, this, [this]() {
+            if(m_tableName.isEmpty())
+                refreshLater();
+        });
+    }
+
+    emit sourceChanged();
+    refreshLater();
+}
+
+TableModel *AggregateModel::source() const
+{
+    return m_source;
+}
+
+void AggregateModel::setDatabaseName(const QString &fileName)
+{
+    if(m_databaseName == fileName)
+        return;
+
+    m_databaseName = fileName;
+    emit databaseNameChanged();
+    refreshLater();
+}
+
+QString AggregateModel::databaseName() const
+{
+    return m_databaseName;
+}
+
+void AggregateModel::setTable(const QString &tableName)
+{
+    if(m_tableName == tableName.trimmed())
+        return;
+
+    m_tableName = tableName.trimmed();
+    emit tableChanged();
+    refreshLater();
+}
+
+QString AggregateModel::tableName() const
+{
+    return m_tableName;
+}
+
+void AggregateModel::setGroupBy(const QString &field)
+{
+    if(m_groupBy == field.trimmed())
+        return;
+
+    m_groupBy = field.trimmed();
+    emit groupByChanged();
+    refreshLater();
+}
+
+QString AggregateModel::groupBy() const
+{
+    return m_groupBy;
+}
+
+void AggregateModel::setAggregates(const QStringList &aggregates)
+{
+    if(m_aggregates == aggregates)
+        return;
+
+    m_aggregates = aggregates;
+    emit aggregatesChanged();
+    refreshLater();
+}
+
+QStringList AggregateModel::aggregates() const
+{
+    return m_aggregates;
+}
+
+void AggregateModel::setFilter(const QString &filter)
+{
+    if(m_filter == filter)
+        return;
+
+    m_filter = filter;
+    emit filterChanged();
+    refreshLater();
+}
+
+QString AggregateModel::filter() const
+{
+    return m_filter;
+}
+
+void AggregateModel::setLiveSync(bool enabled)
+{
+    if(m_liveSync == enabled)
+        return;
+
+    m_liveSync = enabled;
+    updateFeed();
+    emit liveSyncChanged();
+}
+
+bool AggregateModel::liveSync() const
+{
+    return m_liveSync;
+}
+
+bool AggregateModel::isLoading() const
+{
+    return m_pending > 0;
+}
+
+void AggregateModel::refresh()
+{
+    m_refreshQueued = false;
+
+    // the roles follow the aggregates
+    beginResetModel();
+    m_groups.clear();
+    const bool ok = prepare();
+    ++m_generation;
+    m_partials.clear();
+    endResetModel();
+
+    // the database may have changed with the source
+    updateFeed();
+    if(!ok)
+        return;
+
+    QueryTask task;
+    task.kind = QueryTask::Page;
+    task.page = 0;
+    task.statement = selectStatement(QVariantList(), QVariantList(), &task.values);
+    post(task);
+}
+
+QSqlDatabase AggregateModel::database() const
+{
+    // the pooled connection of the database of the source, read only or not
+    if(m_databaseName.isEmpty() && m_source)
+        return m_source->isReadOnly() ? Sql::readOnlyDatabase(m_source->databaseName())
+                                      : Sql::database(m_source->databaseName());
+
+    return Sql::database(m_databaseName);
+}
+
+QString AggregateModel::table() const
+{
+    if(m_tableName.isEmpty() && m_source)
+        return m_source->tableName();
+
+    return m_tableName;
+}
+
+bool AggregateModel::prepare()
+{
+    m_roles.clear();
+    m_expressions.clear();
+    m_groupField.clear();
+
+    QSqlDatabase db = database();
+    SchemaCache::validate(db);
+    if(table().isEmpty() || !SchemaCache::hasTable(db, table()))
+    {
+        reportError(QString("Can not open table '%1' in '%2'").arg(table(), db.databaseName()));
+        return false;
+    }
+
+    const SchemaCache::Table info = SchemaCache::table(db, table());
+    if(info.record.indexOf(m_groupBy) < 0)
+    {
+        reportError(QString("No field '%1' to group table '%2' by").arg(m_groupBy, table()));
+        return false;
+    }
+
+    // fields are checked against the table, they go into the statement
+    QSqlDriver *driver = db.driver();
+    m_groupField = driver->escapeIdentifier(m_groupBy, QSqlDriver::FieldName);
+    m_keyField = info.primaryKey.count() == 1
+            ? driver->escapeIdentifier(info.primaryKey.fieldName(0), QSqlDriver::FieldName)
+            : QStringLiteral("rowid");
+
+    // the groups are kept in the order of the column's collation
+    const QString collation = info.collations.value(m_groupBy.toLower(), QStringLiteral("BINARY"));
+    m_collation = collation == QLatin1String("BINARY") ? BinaryCollation
+                : collation == QLatin1String("NOCASE") ? NoCaseCollation
+                : collation == QLatin1String("RTRIM") ? RTrimCollation : OtherCollation;
+
+    m_roles.insert(GroupRole, "group");
+    static const QRegularExpression pattern("^\\s*(count|sum|avg|min|max)\\s*(?:\\(\\s*(\\*|\\w+)?\\s*\\))?\\s*$",
+                                            QRegularExpression::CaseInsensitiveOption);
+    for (const QString &aggregate : m_aggregates)
+    {
+        const QRegularExpressionMatch match = pattern.match(aggregate);
+        const QString function = match.captured(1).toLower();
+        QString field = match.captured(2);
+        if(field == QLatin1String("*"))
+            field.clear();
+
+        if(!match.hasMatch() || (function != QLatin1String("count") && field.isEmpty())
+                || (!field.isEmpty() && info.record.indexOf(field) < 0))
+        {
+            reportError(QString("Can not aggregate '%1' of table '%2'").arg(aggregate, table()));
+            return false;
+        }
+
+        m_expressions << function.toUpper() + "("
+                         + (field.isEmpty() ? QStringLiteral("*") : driver->escapeIdentifier(field, QSqlDriver::FieldName))
+                         + ")";
+        m_roles.insert(GroupRole + m_roles.count(), (field.isEmpty() ? function : function + "_" + field).toUtf8());
+    }
+
+    return true;
+}
+
+QString AggregateModel::whereClause() const
+{
+    // the rows in use, as the table model shows them by default
+    QStringList where;
+    const SchemaCache::Table info = SchemaCache::table(database(), table());
+    if(info.record.indexOf("deleted_at") >= 0)
+        where << "deleted_at IS NULL";
+    if(!m_filter.isEmpty())
+        where << "(" + m_filter + ")";
+
+    return where.join(" AND ");
+}
+
+QString AggregateModel::selectStatement(const QVariantList &groups, const QVariantList &keys,
+                                        QVariantList *values) const
+{
+    const QString tableName = database().driver()->escapeIdentifier(table(), QSqlDriver::TableName);
+    QStringList where;
+    const QString condition = whereClause();
+    if(!condition.isEmpty())
+        where << condition;
+
+    // the groups of a partial select, NULL is no member of any IN list
+    QStringList terms;
+    if(!groups.isEmpty())
+    {
+        QStringList holders;
+        bool null = false;
+        for (const QVariant &group : groups)
+        {
+            if(group.isNull())
+            {
+                null = true;
+                continue;
+            }
+            holders << QStringLiteral("?");
+            *values << group;
+        }
+
+        if(!holders.isEmpty())
+            terms << m_groupField + " IN (" + holders.join(", ") + ")";
+        if(null)
+            terms << m_groupField + " IS NULL";
+    }
+
+    // and the groups the written rows are in now, by index lookups of the
+    // rows in or out of the filter
+    if(!keys.isEmpty())
+    {
+        QStringList holders;
+        for (int i = 0; i < keys.count(); ++i)
+            holders << QStringLiteral("?");
+        const QString written = " FROM " + tableName + " WHERE " + m_keyField + " IN (" + holders.join(", ") + ")";
+        terms << m_groupField + " IN (SELECT " + m_groupField + written + ")";
+        terms << "(" + m_groupField + " IS NULL AND EXISTS (SELECT 1" + written + " AND " + m_groupField + " IS NULL))";
+        *values << keys << keys;
+    }
+
+    if(!terms.isEmpty())
+        where << "(" + terms.join(" OR ") + ")";
+
+    QString statement = "SELECT " + m_groupField + ", " + m_expressions.join(", ") + " FROM " + tableName;
+    if(!where.isEmpty())
+        statement += " WHERE " + where.join(" AND ");
+
+    return statement + " GROUP BY " + m_groupField + " ORDER BY " + m_groupField;
+}
+
+void AggregateModel::refreshLater()
+{
+    if(!m_completed || m_refreshQueued)
+        return;
+
+    m_refreshQueued = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        if(m_refreshQueued)
+            refresh();
+    }, Qt::QueuedConnection);
+}
+
+void AggregateModel::updateGroups(const QVariantList &groups, const QVariantList &keys)
+{
+    if(!m_completed || m_groupField.isEmpty() || (groups.isEmpty() && keys.isEmpty()))
+        return;
+
+    QVariantList unique;
+    for (const QVariant &group : groups)
+    {
+        if(std::find_if(unique.constBegin(), unique.constEnd(), [this, &group](const QVariant &value) {
+                        return same(group, value, m_collation); }) == unique.constEnd())
+            unique << group;
+    }
+
+    // a write across most groups is read by one select of all of them,
+    // new groups of an unknown collation have no place here
+    if(unique.count() > MaxGroups || keys.count() > MaxGroups || m_collation == OtherCollation)
+    {
+        refreshLater();
+        return;
+    }
+
+    QueryTask task;
+    task.kind = QueryTask::Page;
+    task.page = ++m_serial;
+    task.statement = selectStatement(unique, keys, &task.values);
+    m_partials.insert(task.page, unique);
+    post(task);
+}
+
+void AggregateModel::post(QueryTask task)
+{
+    // the workers of the database, shared with the table models
+    task.databaseName = database().databaseName();
+    if(!m_pool || m_pool->databaseName() != task.databaseName)
+    {
+        if(m_pool)
+            disconnect(m_pool.data(), nullptr, this, nullptr);
+        m_pool = QueryPool::acquire(task.databaseName);
+        connect(m_pool.data(), &QueryPool::finished, this, [this](const QueryResult &result) {
+            if(result.owner == m_owner)
+                onQueryFinished(result);
+        });
+    }
+
+    task.owner = task.origin = m_owner;
+    task.generation = m_generation;
+    if(m_pending++ == 0)
+        emit loadingChanged();
+
+    m_pool->worker(0)->post(task);
+}
+
+void AggregateModel::onQueryFinished(const QueryResult &result)
+{
+    const QVariantList groups = m_partials.take(result.page);
+    if(--m_pending == 0)
+        emit loadingChanged();
+
+    // a select of all groups was issued after this one
+    if(result.generation != m_generation)
+        return;
+
+    if(!result.ok)
+    {
+        reportError("Aggregate error " + result.errorString);
+        return;
+    }
+
+    if(result.page > 0)
+    {
+        applyGroups(result.rows, groups);
+        return;
+    }
+
+    beginResetModel();
+    m_groups.clear();
+    m_groups.reserve(result.rows.count());
+    for (const QSqlRecord &record : result.rows)
+    {
+        Group group;
+        group.value = record.value(0);
+        for (int i = 1; i < record.count(); ++i)
+            group.values << record.value(i);
+        m_groups << group;
+    }
+    endResetModel();
+    qDebug(lcAggregateModel) << table() << "groups:" << m_groups.count();
+}
+
+void AggregateModel::applyGroups(const QVector<QSqlRecord> &rows, const QVariantList &groups)
+{
+    QVariantList seen;
+    for (const QSqlRecord &record : rows)
+    {
+        Group group;
+        group.value = record.value(0);
+        for (int i = 1; i < record.count(); ++i)
+            group.values << record.value(i);
+        seen << group.value;
+
+        bool found = false;
+        const int row = find(group.value, &found);
+        if(found)
+        {
+            if(m_groups.at(row).values == group.values)
+                continue;
+
+            m_groups[row] = group;
+            emit dataChanged(index(row), index(row));
+        }
+        else
+        {
+            beginInsertRows(QModelIndex(), row, row);
+            m_groups.insert(row, group);
+            endInsertRows();
+        }
+    }
+
+    // groups with no rows left
+    for (const QVariant &value : groups)
+    {
+        if(std::find_if(seen.constBegin(), seen.constEnd(), [this, &value](const QVariant &group) {
+                        return same(group, value, m_collation); }) != seen.constEnd())
+            continue;
+
+        bool found = false;
+        const int row = find(value, &found);
+        if(!found)
+            continue;
+
+        beginRemoveRows(QModelIndex(), row, row);
+        m_groups.remove(row);
+        endRemoveRows();
+    }
+}
+
+int AggregateModel::find(const QVariant &value, bool *found) const
+{
+    QVector<Group>::const_iterator it = std::lower_bound(m_groups.constBegin(), m_groups.constEnd(), value,
+                                                         [this](const Group &group, const QVariant &key) {
+        return lessThan(group.value, key, m_collation);
+    });
+
+    *found = it != m_groups.constEnd() && same(it->value, value, m_collation);
+    return int(it - m_groups.constBegin());
+}
+
+void AggregateModel::rowsAboutToBeWritten(const QVariantList &keys)
+{
+    if(!m_completed || m_groupField.isEmpty() || keys.isEmpty() || m_source->tableName() != table())
+        return;
+
+    // the groups the rows leave, as the cache of the source has them; rows
+    // not cached select all groups after the write
+    QVariantList groups;
+    if(!m_source->storedValues(keys, m_groupBy, &groups))
+    {
+        m_beforeUnknown = true;
+        return;
+    }
+
+    for (int i = 0; i < keys.count(); ++i)
+        m_before.insert(keys.at(i).toString(), groups.at(i));
+}
+
+void AggregateModel::rowsWritten(const QVariantList &keys)
+{
+    if(!m_completed || m_source->tableName() != table())
+        return;
+
+    for (const QVariant &key : keys)
+    {
+        if(m_feed)
+            m_written.insert(key.toLongLong());
+    }
+
+    // no keys, anything may have changed
+    if(keys.isEmpty() || m_beforeUnknown)
+    {
+        m_beforeUnknown = false;
+        m_before.clear();
+        refreshLater();
+        return;
+    }
+
+    QVariantList groups;
+    for (const QVariant &key : keys)
+    {
+        QHash<QString, QVariant>::iterator it = m_before.find(key.toString());
+        if(it != m_before.end())
+        {
+            groups << it.value();
+            m_before.erase(it);
+        }
+    }
+
+    updateGroups(groups, keys);
+}
+
+void AggregateModel::applyChanges(const ChangeFeed::ChangeSet &changes)
+{
+    // the writes of the source are applied already
+    QVariantList inserted;
+    bool moved = false;
+    for (qint64 key : changes.inserted)
+    {
+        if(!m_written.contains(key))
+            inserted << key;
+    }
+    for (const QSet<qint64> *keys : { &changes.updated, &changes.deleted })
+    {
+        for (qint64 key : *keys)
+            moved = moved || !m_written.contains(key);
+    }
+    m_written.clear();
+
+    // the group an updated or deleted row was in is not known
+    if(moved)
+        refreshLater();
+    else
+        updateGroups(QVariantList(), inserted);
+}
+
+void AggregateModel::updateFeed()
+{
+    const bool live = m_liveSync && m_completed && !m_keyField.isEmpty();
+    const QString name = database().databaseName();
+    if(m_feed && live && m_feed->databaseName() == name && m_feedTable == table())
+        return;
+
+    if(m_feed)
+    {
+        disconnect(m_feed.data(), nullptr, this, nullptr);
+        m_feed->untrack(m_feedTable);
+    }
+    m_feed.reset();
+    m_feedTable.clear();
+    m_written.clear();
+    if(!live)
+        return;
+
+    m_feed = ChangeFeed::acquire(name);
+    if(!m_feed->isValid())
+    {
+        reportError("No change log for the live sync of " + name + ", see 005_changes.sql");
+        return;
+    }
+
+    // the table is logged while it is followed
+    m_feedTable = table();
+    const QSqlIndex key = SchemaCache::table(database(), m_feedTable).primaryKey;
+    m_feed->track(m_feedTable, key.count() == 1 ? key.fieldName(0) : QStringLiteral("rowid"));
+
+    connect(m_feed.data(), &ChangeFeed::changed, this,
+            [this](const QString &table, const ChangeFeed::ChangeSet &changes, qint64) {
+        if(table == this->table().toLower())
+            applyChanges(changes);
+    });
+    connect(m_feed.data(), &ChangeFeed::overflowed, this, &AggregateModel::refreshLater);
+}
+
+void AggregateModel::reportError(const QString &message)
+{
+    qWarning(lcAggregateModel) << message;
+    emit error(message);
+}
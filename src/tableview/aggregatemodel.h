@@ -0,0 +1,182 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename aggregatemodel.h
+ * @class AggregateModel
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef AGGREGATEMODEL_H
+#define AGGREGATEMODEL_H
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QQmlParserStatus>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QSqlRecord>
+#include <QStringList>
+
+#include "changefeed.h"
+#include "queryworker.h"
+
+class TableModel;
+
+/**
+ * Grouped totals of a table, e.g. per publisher next to the grid.
+ *
+ * `SELECT <groupBy>, <aggregates> FROM <table> WHERE <filter> GROUP BY
+ * <groupBy>` runs on a worker thread, there is one row per group ordered
+ * by the group value. The aggregates are written as `count`, `sum(price)`,
+ * `avg(rating)`, `min(page)` or `max(page)`, each one is a role named
+ * `count`, `sum_price`, ..., the group value is the role `group`. Rows with
+ * deleted_at set are not counted.
+ *
+ * After the first select only the groups a write touched are aggregated
+ * again. The writes of `source`, a SqlTableModel of the same table, tell
+ * their keys before and after they are written: the groups the rows leave
+ * are taken from the cache of the source, the groups they are in now are
+ * looked up by the select of the worker itself. Groups are kept in the
+ * order of the collation of the group field (BINARY, NOCASE or RTRIM), as
+ * SQLite sorts them; any other one selects all groups. With liveSync the
+ * rows inserted by other connections update their groups the same way;
+ * their updates and deletes carry no old values in the _changes log and
+ * select all groups again, once per burst of writes.
+ */
+class AggregateModel : public QAbstractListModel, public QQmlParserStatus
+{
+    Q_OBJECT
+    Q_INTERFACES(QQmlParserStatus)
+    Q_PROPERTY(TableModel *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QString database READ databaseName WRITE setDatabaseName NOTIFY databaseNameChanged)
+    Q_PROPERTY(QString table READ tableName WRITE setTable NOTIFY tableChanged)
+    Q_PROPERTY(QString groupBy READ groupBy WRITE setGroupBy NOTIFY groupByChanged)
+    Q_PROPERTY(QStringList aggregates READ aggregates WRITE setAggregates NOTIFY aggregatesChanged)
+    Q_PROPERTY(QString filter READ filter WRITE setFilter NOTIFY filterChanged)
+    Q_PROPERTY(bool liveSync READ liveSync WRITE setLiveSync NOTIFY liveSyncChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+public:
+    explicit AggregateModel(QObject *parent = nullptr);
+    ~AggregateModel() override;
+
+    void classBegin() override;
+    void componentComplete() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // the roles of a group by name
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+    // database and table follow the source unless they are set
+    void setSource(TableModel *model);
+    TableModel *source() const;
+
+    void setDatabaseName(const QString &fileName);
+    QString databaseName() const;
+
+    void setTable(const QString &tableName);
+    QString tableName() const;
+
+    void setGroupBy(const QString &field);
+    QString groupBy() const;
+
+    void setAggregates(const QStringList &aggregates);
+    QStringList aggregates() const;
+
+    void setFilter(const QString &filter);
+    QString filter() const;
+
+    void setLiveSync(bool enabled);
+    bool liveSync() const;
+
+    bool isLoading() const;
+
+signals:
+    void sourceChanged();
+    void databaseNameChanged();
+    void tableChanged();
+    void groupByChanged();
+    void aggregatesChanged();
+    void filterChanged();
+    void liveSyncChanged();
+    void loadingChanged();
+    void error(const QString &message);
+
+public slots:
+    void refresh();
+
+private:
+    struct Group
+    {
+        QVariant value;
+        QVector<QVariant> values;
+    };
+
+    QSqlDatabase database() const;
+    QString table() const;
+    bool prepare();
+    QString whereClause() const;
+    QString selectStatement(const QVariantList &groups, const QVariantList &keys, QVariantList *values) const;
+    void refreshLater();
+    void updateGroups(const QVariantList &groups, const QVariantList &keys);
+    void post(QueryTask task);
+    void onQueryFinished(const QueryResult &result);
+    void applyGroups(const QVector<QSqlRecord> &rows, const QVariantList &groups);
+    int find(const QVariant &value, bool *found) const;
+    void rowsAboutToBeWritten(const QVariantList &keys);
+    void rowsWritten(const QVariantList &keys);
+    void applyChanges(const ChangeFeed::ChangeSet &changes);
+    void updateFeed();
+    void reportError(const QString &message);
+
+    QPointer<TableModel> m_source;
+    QString m_databaseName;
+    QString m_tableName;
+    QString m_groupBy;
+    QStringList m_aggregates;
+    QString m_filter;
+    bool m_liveSync = false;
+    bool m_completed = false;
+    bool m_refreshQueued = false;
+
+    // the columns of the select, validated against the table
+    QString m_groupField;
+    QString m_keyField;
+    int m_collation = 0;                    // of the group field, as SQLite orders the groups
+    QStringList m_expressions;
+    QHash<int, QByteArray> m_roles;
+
+    QVector<Group> m_groups;
+    int m_generation = 0;
+    int m_serial = 0;
+    int m_pending = 0;
+    QHash<int, QVariantList> m_partials;    // groups of a partial select by task
+    QHash<QString, QVariant> m_before;      // groups of rows being written, by key
+    bool m_beforeUnknown = false;           // rows written that were not cached
+    QSet<qint64> m_written;                 // keys written by the source since the last feed
+
+    QSharedPointer<QueryPool> m_pool;
+    int m_owner = QueryPool::nextOwner();
+    QSharedPointer<ChangeFeed> m_feed;
+    QString m_feedTable;                    // tracked by the feed
+};
+
+#endif // AGGREGATEMODEL_H
@@ -0,0 +1,332 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename changefeed.cpp
+ * @class ChangeFeed
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "changefeed.h"
+#include "schemacache.h"
+#include "sql.h"
+
+#include <QHash>
+#include <QLoggingCategory>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QWeakPointer>
+
+Q_LOGGING_CATEGORY(lcChangeFeed, "app.ChangeFeed")
+
+// ms between two looks at the data version
+static const int Interval = 200;
+
+// the longest a burst of writes is collected before it is read
+static const int MaxDelay = 1000;
+
+// changes read at once, a larger burst selects again
+static const int MaxChanges = 10000;
+
+static QHash<QString, QWeakPointer<ChangeFeed> > &feeds()
+{
+    static QHash<QString, QWeakPointer<ChangeFeed> > hash;
+    return hash;
+}
+
+QSharedPointer<ChangeFeed> ChangeFeed::acquire(const QString &databaseName)
+{
+    QSharedPointer<ChangeFeed> feed = feeds().value(databaseName).toStrongRef();
+    if(feed)
+        return feed;
+
+    feed = QSharedPointer<ChangeFeed>(new ChangeFeed(databaseName), &QObject::deleteLater);
+    feeds().insert(databaseName, feed);
+    return feed;
+}
+
+ChangeFeed::ChangeFeed(const QString &databaseName)
+    : m_databaseName(databaseName)
+{
+    // a connection of its own sees the commits of the pooled ones as well
+    m_db = Sql::addConnection(databaseName);
+    m_valid = m_db.isOpen() && SchemaCache::hasTable(m_db, "_changes");
+    if(!m_valid)
+    {
+        qWarning(lcChangeFeed) << "No change log in" << databaseName;
+        return;
+    }
+
+    QSqlQuery query(m_db);
+    if(query.exec("SELECT MAX(seq) FROM _changes") && query.next())
+        m_seq = query.value(0).toLongLong();
+    if(query.exec("PRAGMA data_version") && query.next())
+        m_dataVersion = query.value(0).toLongLong();
+    if(query.exec("PRAGMA schema_version") && query.next())
+        m_schemaVersion = query.value(0).toInt();
+
+    m_timer.setInterval(Interval);
+    connect(&m_timer, &QTimer::timeout, this, &ChangeFeed::poll);
+    m_timer.start();
+}
+
+ChangeFeed::~ChangeFeed()
+{
+    // the tables of models that went without untrack()
+    for (const Tracked &tracked : m_tracked)
+        release(tracked.table);
+    m_tracked.clear();
+
+    QHash<QString, QWeakPointer<ChangeFeed> >::iterator it = feeds().find(m_databaseName);
+    if(it != feeds().end() && it->isNull())
+        feeds().erase(it);
+
+    const QString connectionName = m_db.connectionName();
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QString ChangeFeed::databaseName() const
+{
+    return m_databaseName;
+}
+
+bool ChangeFeed::isValid() const
+{
+    return m_valid;
+}
+
+void ChangeFeed::track(const QString &table, const QString &keyField)
+{
+    if(!m_valid)
+        return;
+
+    Tracked &tracked = m_tracked[table.toLower()];
+    if(tracked.users++ > 0)
+        return;
+
+    tracked.table = table;
+    tracked.keyField = keyField;
+
+    // the users of all processes, the triggers stay while there is one
+    m_db.transaction();
+    QSqlQuery query(m_db);
+    query.prepare("INSERT INTO _changes_tracked (tbl, users) VALUES (?, 1) "
+                  "ON CONFLICT (tbl) DO UPDATE SET users = users + 1");
+    query.addBindValue(table.toLower());
+    bool ok = query.exec() && install(tracked);
+    if(!ok)
+        qWarning(lcChangeFeed) << "Track error" << table << query.lastError().text();
+    query.finish();
+    ok = ok && m_db.commit();
+
+    // tried again by the next model
+    if(!ok)
+    {
+        m_db.rollback();
+        m_tracked.remove(table.toLower());
+    }
+}
+
+void ChangeFeed::untrack(const QString &table)
+{
+    QHash<QString, Tracked>::iterator it = m_tracked.find(table.toLower());
+    if(it == m_tracked.end() || --it->users > 0)
+        return;
+
+    release(it->table);
+    m_tracked.erase(it);
+}
+
+bool ChangeFeed::install(const Tracked &tracked)
+{
+    static const char *const events[] = { "INSERT", "UPDATE", "DELETE" };
+    QSqlDriver *driver = m_db.driver();
+    const QString table = driver->escapeIdentifier(tracked.table, QSqlDriver::TableName);
+    QString literal = tracked.table.toLower();
+    literal.replace(QLatin1Char('\''), QLatin1String("''"));
+
+    // installed already, no write to the schema
+    QStringList names;
+    for (const char *event : events)
+        names << tracked.table + "_changes_" + QString::fromLatin1(event).toLower();
+
+    QSqlQuery query(m_db);
+    query.prepare("SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' AND name IN (?, ?, ?)");
+    for (const QString &name : names)
+        query.addBindValue(name);
+    if(query.exec() && query.next() && query.value(0).toInt() == names.count())
+        return true;
+
+    for (int i = 0; i < names.count(); ++i)
+    {
+        const QString event = QString::fromLatin1(events[i]);
+        const QString row = (i == 2 ? "old." : "new.")
+                + driver->escapeIdentifier(tracked.keyField, QSqlDriver::FieldName);
+        const QString statement = QString("CREATE TRIGGER IF NOT EXISTS %1 AFTER %2 ON %3 BEGIN "
+                                          "INSERT INTO _changes (tbl, row, op) VALUES ('%4', %5, '%6'); END")
+                .arg(driver->escapeIdentifier(names.at(i), QSqlDriver::TableName), event, table,
+                     literal, row, event.left(1));
+        if(!query.exec(statement))
+        {
+            qWarning(lcChangeFeed) << "Install triggers error" << tracked.table << query.lastError().text();
+            return false;
+        }
+    }
+
+    // the DDL of its own is no change of the schema to look at
+    if(query.exec("PRAGMA schema_version") && query.next())
+        m_schemaVersion = query.value(0).toInt();
+    return true;
+}
+
+void ChangeFeed::release(const QString &table)
+{
+    m_db.transaction();
+    QSqlQuery query(m_db);
+    query.prepare("UPDATE _changes_tracked SET users = users - 1 WHERE tbl = ?");
+    query.addBindValue(table.toLower());
+    bool ok = query.exec();
+
+    // the last user of all processes drops the triggers
+    query.prepare("SELECT users FROM _changes_tracked WHERE tbl = ?");
+    query.addBindValue(table.toLower());
+    if(ok && query.exec() && query.next() && query.value(0).toInt() <= 0)
+    {
+        query.finish();
+        query.prepare("DELETE FROM _changes_tracked WHERE tbl = ?");
+        query.addBindValue(table.toLower());
+        ok = query.exec();
+        static const char *const events[] = { "insert", "update", "delete" };
+        for (const char *event : events)
+        {
+            const QString name = m_db.driver()->escapeIdentifier(table + "_changes_" + QLatin1String(event),
+                                                                 QSqlDriver::TableName);
+            ok = ok && query.exec("DROP TRIGGER IF EXISTS " + name);
+        }
+    }
+    if(!ok)
+        qWarning(lcChangeFeed) << "Untrack error" << table << query.lastError().text();
+    query.finish();
+    if(!ok || !m_db.commit())
+        m_db.rollback();
+}
+
+void ChangeFeed::poll()
+{
+    QSqlQuery query(m_db);
+
+    // the triggers go with a table dropped, also by another process
+    if(!m_tracked.isEmpty() && query.exec("PRAGMA schema_version") && query.next()
+            && query.value(0).toInt() != m_schemaVersion)
+    {
+        m_schemaVersion = query.value(0).toInt();
+        for (const Tracked &tracked : m_tracked)
+            install(tracked);
+    }
+
+    if(!query.exec("PRAGMA data_version") || !query.next())
+        return;
+
+    // still being written, read once it settles
+    const qint64 version = query.value(0).toLongLong();
+    if(version != m_dataVersion)
+    {
+        m_dataVersion = version;
+        if(!m_pendingSince.isValid())
+            m_pendingSince.start();
+        if(m_pendingSince.elapsed() < MaxDelay)
+            return;
+    }
+
+    if(!m_pendingSince.isValid())
+        return;
+
+    m_pendingSince.invalidate();
+    readChanges();
+}
+
+void ChangeFeed::readChanges()
+{
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT seq, tbl, row, op FROM _changes WHERE seq > ? ORDER BY seq LIMIT ?");
+    query.addBindValue(m_seq);
+    query.addBindValue(MaxChanges + 1);
+    if(!query.exec())
+    {
+        qWarning(lcChangeFeed) << "Read changes error" << query.lastQuery();
+        return;
+    }
+
+    // seq has no gaps but the pruned ones
+    QHash<QString, ChangeSet> tables;
+    const qint64 from = m_seq;
+    int read = 0;
+    bool lost = false;
+    while (query.next())
+    {
+        const qint64 seq = query.value(0).toLongLong();
+        if(read == 0 && from > 0 && seq != from + 1)
+            lost = true;
+        if(++read > MaxChanges)
+        {
+            lost = true;
+            break;
+        }
+
+        m_seq = seq;
+        ChangeSet &changes = tables[query.value(1).toString().toLower()];
+        const qint64 row = query.value(2).toLongLong();
+        const QString op = query.value(3).toString();
+        if(op == QLatin1String("I"))
+        {
+            changes.inserted.insert(row);
+        }
+        else if(op == QLatin1String("U"))
+        {
+            if(!changes.inserted.contains(row))
+                changes.updated.insert(row);
+        }
+        else if(!changes.inserted.remove(row))
+        {
+            changes.updated.remove(row);
+            changes.deleted.insert(row);
+        }
+    }
+    query.finish();
+
+    if(lost)
+    {
+        // the rest of the burst is seen by the select
+        if(query.exec("SELECT MAX(seq) FROM _changes") && query.next())
+            m_seq = query.value(0).toLongLong();
+        qDebug(lcChangeFeed) << "overflowed after" << from;
+        emit overflowed();
+        return;
+    }
+
+    for (QHash<QString, ChangeSet>::const_iterator it = tables.constBegin(); it != tables.constEnd(); ++it)
+    {
+        qDebug(lcChangeFeed) << it.key() << "inserted" << it->inserted.count()
+                             << "updated" << it->updated.count() << "deleted" << it->deleted.count();
+        emit changed(it.key(), it.value(), m_seq);
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename changefeed.h
+ * @class ChangeFeed
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef CHANGEFEED_H
+#define CHANGEFEED_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSqlDatabase>
+#include <QTimer>
+
+/**
+ * The rows written to one database by any connection or process, read
+ * from the `_changes` log of 005_changes.sql.
+ *
+ * The log is written by triggers on the tables that are followed only:
+ * track() installs them for the first model of any process, untrack()
+ * drops them after the last one, counted in `_changes_tracked`. A process
+ * that ends without untrack() leaves the triggers of its tables until the
+ * next process releases them. Triggers lost with their table are installed
+ * again once `PRAGMA schema_version` changed.
+ *
+ * A feed is shared by all models of a database through acquire(). Every
+ * `interval` ms it asks its own connection for `PRAGMA data_version`,
+ * which changes only when another connection committed, and reads the log
+ * once the writes have settled for one interval, or after one second of
+ * writes that go on. The rows of a burst are merged by table into one
+ * ChangeSet: a row inserted and deleted again is gone, an update of an
+ * inserted row is an insert.
+ *
+ * The log keeps the last 100000 changes. A feed that fell behind further
+ * gets overflowed() and its models select again.
+ */
+class ChangeFeed : public QObject
+{
+    Q_OBJECT
+public:
+    struct ChangeSet
+    {
+        QSet<qint64> inserted;
+        QSet<qint64> updated;
+        QSet<qint64> deleted;
+    };
+
+    static QSharedPointer<ChangeFeed> acquire(const QString &databaseName);
+    ~ChangeFeed() override;
+
+    QString databaseName() const;
+
+    // false for a database without the _changes log
+    bool isValid() const;
+
+    // the writes of a table are logged by key while it is tracked, keyField
+    // is the column name as is, or rowid
+    void track(const QString &table, const QString &keyField);
+    void untrack(const QString &table);
+
+signals:
+    // table in lower case, seq is the last change read
+    void changed(const QString &table, const ChangeFeed::ChangeSet &changes, qint64 seq);
+    void overflowed();
+
+private:
+    struct Tracked
+    {
+        QString table;
+        QString keyField;
+        int users = 0;
+    };
+
+    explicit ChangeFeed(const QString &databaseName);
+
+    void poll();
+    void readChanges();
+    bool install(const Tracked &tracked);
+    void release(const QString &table);
+
+    QString m_databaseName;
+    QSqlDatabase m_db;
+    QTimer m_timer;
+    QElapsedTimer m_pendingSince;
+    QHash<QString, Tracked> m_tracked;  // by lower case name
+    int m_schemaVersion = -1;
+    qint64 m_dataVersion = -1;
+    qint64 m_seq = 0;
+    bool m_valid = false;
+};
+
+#endif // CHANGEFEED_H
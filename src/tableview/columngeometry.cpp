@@ -0,0 +1,277 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename columngeometry.cpp
+ * @class ColumnGeometry
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "columngeometry.h"
+
+#include <QGuiApplication>
+
+// longer values are elided by the delegate, no need to measure all of it
+static const int MaxMeasuredLength = 256;
+
+ColumnGeometry::ColumnGeometry(QObject *parent)
+    : QObject(parent)
+    , m_font(QGuiApplication::font())
+    , m_fontMetrics(m_font)
+{
+
+}
+
+QList<qreal> ColumnGeometry::widths() const
+{
+    return m_widths;
+}
+
+qreal ColumnGeometry::totalWidth() const
+{
+    return m_totalWidth;
+}
+
+qreal ColumnGeometry::width(int column) const
+{
+    return m_widths.value(column, m_minimumWidth);
+}
+
+void ColumnGeometry::setWidth(int column, qreal width)
+{
+    if(column < 0 || column >= m_columns.count())
+        return;
+
+    Column &c = m_columns[column];
+    const qreal fixed = qMax<qreal>(0, width);
+    if(qFuzzyCompare(c.fixed + 1, fixed + 1))
+        return;
+
+    c.fixed = fixed;
+    c.dirty = true;
+    updateWidths();
+}
+
+qreal ColumnGeometry::viewWidth() const
+{
+    return m_viewWidth;
+}
+
+void ColumnGeometry::setViewWidth(qreal width)
+{
+    if(qFuzzyCompare(m_viewWidth + 1, width + 1))
+        return;
+
+    // the natural widths stay, only the stretch is spread again
+    m_viewWidth = width;
+    updateWidths();
+    emit viewWidthChanged();
+}
+
+bool ColumnGeometry::autoSize() const
+{
+    return m_autoSize;
+}
+
+void ColumnGeometry::setAutoSize(bool enabled)
+{
+    if(m_autoSize == enabled)
+        return;
+
+    m_autoSize = enabled;
+    invalidate();
+    emit autoSizeChanged();
+}
+
+bool ColumnGeometry::stretch() const
+{
+    return m_stretch;
+}
+
+void ColumnGeometry::setStretch(bool enabled)
+{
+    if(m_stretch == enabled)
+        return;
+
+    m_stretch = enabled;
+    updateWidths();
+    emit stretchChanged();
+}
+
+qreal ColumnGeometry::minimumWidth() const
+{
+    return m_minimumWidth;
+}
+
+void ColumnGeometry::setMinimumWidth(qreal width)
+{
+    if(qFuzzyCompare(m_minimumWidth, width))
+        return;
+
+    m_minimumWidth = width;
+    for (Column &c : m_columns)
+        c.dirty = true;
+    updateWidths();
+    emit minimumWidthChanged();
+}
+
+qreal ColumnGeometry::maximumWidth() const
+{
+    return m_maximumWidth;
+}
+
+void ColumnGeometry::setMaximumWidth(qreal width)
+{
+    if(qFuzzyCompare(m_maximumWidth, width))
+        return;
+
+    // values cut at the old maximum may be wider, they are sampled again
+    m_maximumWidth = width;
+    invalidate();
+    emit maximumWidthChanged();
+}
+
+qreal ColumnGeometry::padding() const
+{
+    return m_padding;
+}
+
+void ColumnGeometry::setPadding(qreal padding)
+{
+    if(qFuzzyCompare(m_padding + 1, padding + 1))
+        return;
+
+    m_padding = padding;
+    for (Column &c : m_columns)
+        c.dirty = true;
+    updateWidths();
+    emit paddingChanged();
+}
+
+QFont ColumnGeometry::font() const
+{
+    return m_font;
+}
+
+void ColumnGeometry::setFont(const QFont &font)
+{
+    if(m_font == font)
+        return;
+
+    m_font = font;
+    m_fontMetrics = QFontMetricsF(font);
+    invalidate();
+    emit fontChanged();
+}
+
+void ColumnGeometry::setHeaders(const QStringList &headers)
+{
+    m_headers = headers;
+    m_columns = QVector<Column>(headers.count());
+    for (int i = 0; i < headers.count(); ++i)
+        m_columns[i].header = textWidth(headers.at(i));
+
+    updateWidths();
+}
+
+bool ColumnGeometry::canWiden(int column) const
+{
+    if(!m_autoSize || column < 0 || column >= m_columns.count())
+        return false;
+
+    const Column &c = m_columns.at(column);
+    return c.fixed <= 0 && c.content + 2 * m_padding < m_maximumWidth;
+}
+
+void ColumnGeometry::measure(int column, const QString &text)
+{
+    if(!canWiden(column) || text.isEmpty())
+        return;
+
+    const qreal width = textWidth(text);
+    Column &c = m_columns[column];
+    if(width > c.content)
+    {
+        c.content = width;
+        c.dirty = true;
+    }
+}
+
+void ColumnGeometry::updateWidths()
+{
+    // only the columns measured wider or changed are computed again
+    qreal natural = 0;
+    int stretched = 0;
+    for (Column &c : m_columns)
+    {
+        if(c.dirty)
+        {
+            if(c.fixed > 0)
+                c.natural = c.fixed;
+            else if(m_autoSize)
+                c.natural = qBound(m_minimumWidth, qMax(c.header, c.content) + 2 * m_padding, m_maximumWidth);
+            else
+                c.natural = m_minimumWidth;
+            c.dirty = false;
+        }
+
+        natural += c.natural;
+        if(c.fixed <= 0)
+            ++stretched;
+    }
+
+    // the width left in the view, spread evenly
+    const qreal extra = m_stretch && stretched > 0 && m_viewWidth > natural
+            ? (m_viewWidth - natural) / stretched : 0;
+
+    QList<qreal> widths;
+    widths.reserve(m_columns.count());
+    qreal total = 0;
+    for (const Column &c : m_columns)
+    {
+        const qreal width = c.fixed > 0 ? c.natural : c.natural + extra;
+        widths.append(width);
+        total += width;
+    }
+
+    if(widths == m_widths)
+        return;
+
+    m_widths = widths;
+    m_totalWidth = total;
+    emit widthsChanged();
+}
+
+qreal ColumnGeometry::textWidth(const QString &text) const
+{
+    return m_fontMetrics.horizontalAdvance(text.left(MaxMeasuredLength));
+}
+
+void ColumnGeometry::invalidate()
+{
+    for (int i = 0; i < m_columns.count(); ++i)
+    {
+        Column &c = m_columns[i];
+        c.header = textWidth(m_headers.at(i));
+        c.content = 0;
+        c.dirty = true;
+    }
+
+    updateWidths();
+    emit remeasure();
+}
@@ -0,0 +1,139 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename columngeometry.h
+ * @class ColumnGeometry
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef COLUMNGEOMETRY_H
+#define COLUMNGEOMETRY_H
+
+#include <QObject>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * The column widths of a TableModel, read in QML by `tableModel.geometry`.
+ *
+ * Widths are computed in C++ and published as one array, `widths`, which
+ * the columnWidthProvider of a TableView and the header delegates index.
+ * `widthsChanged` is emitted only when a width really changes, that is the
+ * one point to call TableView.forceLayout().
+ *
+ * Without autoSize every column gets an equal share of `viewWidth`. With
+ * autoSize a column is as wide as its header and the widest of the values
+ * sampled from every page loaded, bounded by minimumWidth and maximumWidth,
+ * and `stretch` spreads the width left in the view over the columns. A page
+ * grows only the columns it has a wider value for, the other widths are
+ * kept. Fixed widths set by setWidth() are kept as they are.
+ */
+class ColumnGeometry : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QList<qreal> widths READ widths NOTIFY widthsChanged)
+    Q_PROPERTY(qreal totalWidth READ totalWidth NOTIFY widthsChanged)
+    Q_PROPERTY(qreal viewWidth READ viewWidth WRITE setViewWidth NOTIFY viewWidthChanged)
+    Q_PROPERTY(bool autoSize READ autoSize WRITE setAutoSize NOTIFY autoSizeChanged)
+    Q_PROPERTY(bool stretch READ stretch WRITE setStretch NOTIFY stretchChanged)
+    Q_PROPERTY(qreal minimumWidth READ minimumWidth WRITE setMinimumWidth NOTIFY minimumWidthChanged)
+    Q_PROPERTY(qreal maximumWidth READ maximumWidth WRITE setMaximumWidth NOTIFY maximumWidthChanged)
+    Q_PROPERTY(qreal padding READ padding WRITE setPadding NOTIFY paddingChanged)
+    Q_PROPERTY(QFont font READ font WRITE setFont NOTIFY fontChanged)
+public:
+    explicit ColumnGeometry(QObject *parent = nullptr);
+
+    QList<qreal> widths() const;
+    qreal totalWidth() const;
+    Q_INVOKABLE qreal width(int column) const;
+
+    // a width of 0 or less gives the column back to the computation
+    Q_INVOKABLE void setWidth(int column, qreal width);
+
+    qreal viewWidth() const;
+    void setViewWidth(qreal width);
+
+    bool autoSize() const;
+    void setAutoSize(bool enabled);
+
+    bool stretch() const;
+    void setStretch(bool enabled);
+
+    qreal minimumWidth() const;
+    void setMinimumWidth(qreal width);
+
+    qreal maximumWidth() const;
+    void setMaximumWidth(qreal width);
+
+    qreal padding() const;
+    void setPadding(qreal padding);
+
+    QFont font() const;
+    void setFont(const QFont &font);
+
+    // by the model: new columns drop all measures, measure() widens the
+    // content of a column and updateWidths() publishes the result
+    void setHeaders(const QStringList &headers);
+    bool canWiden(int column) const;
+    void measure(int column, const QString &text);
+    void updateWidths();
+
+signals:
+    void widthsChanged();
+    void viewWidthChanged();
+    void autoSizeChanged();
+    void stretchChanged();
+    void minimumWidthChanged();
+    void maximumWidthChanged();
+    void paddingChanged();
+    void fontChanged();
+
+    // the measured values are dropped, the model samples its rows again
+    void remeasure();
+
+private:
+    struct Column
+    {
+        qreal header = 0;
+        qreal content = 0;
+        qreal fixed = 0;
+        qreal natural = 0;
+        bool dirty = true;
+    };
+
+    qreal textWidth(const QString &text) const;
+    void invalidate();
+
+    QVector<Column> m_columns;
+    QStringList m_headers;
+    QList<qreal> m_widths;
+    qreal m_totalWidth = 0;
+    qreal m_viewWidth = 0;
+    bool m_autoSize = false;
+    bool m_stretch = true;
+    qreal m_minimumWidth = 40;
+    qreal m_maximumWidth = 400;
+    qreal m_padding = 4;
+    QFont m_font;
+    QFontMetricsF m_fontMetrics;
+};
+
+#endif // COLUMNGEOMETRY_H
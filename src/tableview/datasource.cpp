@@ -0,0 +1,214 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename datasource.cpp
+ * @class DataSource
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "datasource.h"
+
+#include <QHash>
+#include <QLoggingCategory>
+#include <QWeakPointer>
+
+Q_LOGGING_CATEGORY(lcDataSource, "app.DataSource")
+
+// sources in use by key, all models live in the GUI thread
+static QHash<QString, QWeakPointer<DataSource> > &sources()
+{
+    static QHash<QString, QWeakPointer<DataSource> > hash;
+    return hash;
+}
+
+QSharedPointer<DataSource> DataSource::acquire(const QString &key, int pageSize, int capacity)
+{
+    if(!key.isEmpty())
+    {
+        QSharedPointer<DataSource> source = sources().value(key).toStrongRef();
+        if(source)
+        {
+            // the largest cache asked for by one of the views
+            if(capacity > source->pages.capacity())
+                source->pages.setCapacity(capacity);
+            qDebug(lcDataSource) << "share" << key;
+            return source;
+        }
+    }
+
+    // deleted later, a view may let go of it while it emits
+    QSharedPointer<DataSource> source(new DataSource(key, pageSize, capacity), &QObject::deleteLater);
+    if(!key.isEmpty())
+        sources().insert(key, source);
+
+    return source;
+}
+
+DataSource::DataSource(const QString &key, int pageSize, int capacity)
+    : pages(pageSize, capacity)
+    , m_key(key)
+    , m_owner(QueryPool::nextOwner())
+{
+
+}
+
+DataSource::~DataSource()
+{
+    // a source of the same key may be in use again already
+    QHash<QString, QWeakPointer<DataSource> >::iterator it = sources().find(m_key);
+    if(it != sources().end() && it->isNull())
+        sources().erase(it);
+}
+
+QString DataSource::key() const
+{
+    return m_key;
+}
+
+bool DataSource::isShared() const
+{
+    return !m_key.isEmpty();
+}
+
+void DataSource::setReaders(int readers)
+{
+    // workers started already stay with the pool, their queued tasks
+    // still finish
+    m_readers = qMax(1, readers);
+    m_nextReader = 0;
+}
+
+int DataSource::readers() const
+{
+    return m_readers;
+}
+
+QueryWorker *DataSource::worker(const QueryTask &task)
+{
+    // the source of a model of its own may be used with another database
+    if(!m_pool || m_pool->databaseName() != task.databaseName)
+    {
+        if(m_pool)
+            disconnect(m_pool.data(), nullptr, this, nullptr);
+        m_pool = QueryPool::acquire(task.databaseName);
+        connect(m_pool.data(), &QueryPool::finished, this, &DataSource::onQueryFinished);
+    }
+
+    int index = 0;
+    if(task.kind == QueryTask::Page && m_readers > 1)
+    {
+        index = m_nextReader;
+        m_nextReader = (m_nextReader + 1) % m_readers;
+    }
+
+    return m_pool->worker(index);
+}
+
+void DataSource::post(QueryTask task)
+{
+    task.owner = m_owner;
+    task.generation = generation;
+    task.serial = serial;
+    if(task.kind == QueryTask::Count)
+        counting = true;
+    else if(task.kind == QueryTask::Page)
+        pendingPages.insert(task.page);
+
+    ++tasksIssued;
+    worker(task)->post(task);
+}
+
+void DataSource::store(int page, const QVector<QSqlRecord> &rows)
+{
+    if(rows.isEmpty())
+        return;
+
+    pages.insert(page, rows);
+    emit pageStored(page, rows);
+}
+
+void DataSource::setCount(int rows)
+{
+    counting = false;
+    if(count == rows)
+        return;
+
+    count = rows;
+    emit counted(rows);
+}
+
+void DataSource::reset(QObject *origin)
+{
+    ++generation;
+    pages.clear();
+    pendingPages.clear();
+    count = -1;
+    estimate = -1;
+    counting = false;
+    tasksIssued = tasksDone = 0;
+    emit wasReset(origin);
+}
+
+void DataSource::changeRows(QObject *origin, int first, int last)
+{
+    emit rowsChanged(origin, first, last);
+}
+
+void DataSource::removeRows(QObject *origin, int first, int last)
+{
+    if(count >= 0)
+        count = qMax(0, count - (last - first + 1));
+    emit rowsRemoved(origin, first, last);
+}
+
+void DataSource::insertRows(QObject *origin, int first, int last)
+{
+    if(count >= 0)
+        count += last - first + 1;
+    emit rowsInserted(origin, first, last);
+}
+
+void DataSource::onQueryFinished(const QueryResult &result)
+{
+    // posted by another user of the pool, or belongs to a previous select
+    if(result.owner != m_owner || result.generation != generation)
+        return;
+
+    ++tasksDone;
+    if(result.kind == QueryTask::Page)
+    {
+        // a page read before a write is read again by the views
+        pendingPages.remove(result.page);
+        if(result.ok && result.serial == serial)
+            store(result.page, result.rows);
+    }
+    else if(result.kind == QueryTask::Count)
+    {
+        counting = false;
+    }
+    else if(result.kind == QueryTask::Estimate && result.ok && count < 0)
+    {
+        estimate = result.count;
+    }
+
+    emit finished(result);
+
+    if(result.ok && result.kind == QueryTask::Count)
+        setCount(result.count);
+}
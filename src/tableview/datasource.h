@@ -0,0 +1,113 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename datasource.h
+ * @class DataSource
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef DATASOURCE_H
+#define DATASOURCE_H
+
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "pagecache.h"
+#include "queryworker.h"
+
+/**
+ * The rows of one windowed select, shared by all models that show them.
+ *
+ * A source is keyed by the statement of its pages: database, table,
+ * projection, filter, search, sort and page size. Models with the same key
+ * get the same source from acquire() and share its page cache and its row
+ * count, so a table shown in several views is read and held once. The
+ * count and page queries run on the QueryPool of the database, shared with
+ * the other sources of it. The source goes away with the last model that
+ * holds it.
+ *
+ * Results of the worker are stored once and then handed to every model by
+ * finished(), the model that posted a task is its origin. Changes made
+ * through one model are announced to the others with the model as origin,
+ * which has updated its own view already.
+ */
+class DataSource : public QObject
+{
+    Q_OBJECT
+public:
+    // an empty key gives a source of its own, shared with no other model
+    static QSharedPointer<DataSource> acquire(const QString &key, int pageSize, int capacity);
+    ~DataSource() override;
+
+    QString key() const;
+    bool isShared() const;
+
+    // page reads go round this many workers of the pool; everything else,
+    // and all of it for a writable database, keeps its order on the first
+    void setReaders(int readers);
+    int readers() const;
+
+    // the task runs with the generation and serial of now
+    void post(QueryTask task);
+    void store(int page, const QVector<QSqlRecord> &rows);
+    void setCount(int count);
+
+    // drops the rows, results in flight are dropped by generation
+    void reset(QObject *origin);
+
+    void changeRows(QObject *origin, int first, int last);
+    void removeRows(QObject *origin, int first, int last);
+    void insertRows(QObject *origin, int first, int last);
+
+    PageCache pages;
+    int count = -1;             // -1 until counted
+    int estimate = -1;          // rows shown until counted, -1 for none
+    bool counting = false;
+    int generation = 0;
+    int serial = 0;             // bumped by writes, pages read before are stale
+    QSet<int> pendingPages;
+    qint64 syncedSeq = 0;       // the last change applied by a live view
+    QSet<qint64> written;       // keys written by the views since, skipped by the feed
+    int tasksIssued = 0;
+    int tasksDone = 0;
+
+signals:
+    void finished(const QueryResult &result);
+    void pageStored(int page, const QVector<QSqlRecord> &rows);
+    void counted(int count);
+    void wasReset(QObject *origin);
+    void rowsChanged(QObject *origin, int first, int last);
+    void rowsRemoved(QObject *origin, int first, int last);
+    void rowsInserted(QObject *origin, int first, int last);
+
+private:
+    DataSource(const QString &key, int pageSize, int capacity);
+
+    QueryWorker *worker(const QueryTask &task);
+    void onQueryFinished(const QueryResult &result);
+
+    QString m_key;
+    int m_owner;
+    QSharedPointer<QueryPool> m_pool;
+    int m_readers = 1;
+    int m_nextReader = 0;
+};
+
+#endif // DATASOURCE_H
@@ -0,0 +1,279 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename exporter.cpp
+ * @class Exporter
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "exporter.h"
+#include "sql.h"
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcExporter, "app.Exporter")
+
+static QByteArray csvField(const QVariant &value)
+{
+    if(value.isNull())
+        return QByteArray();
+
+    QByteArray field = value.type() == QVariant::ByteArray
+            ? value.toByteArray().toBase64() : value.toString().toUtf8();
+
+    // quoted only when needed, a quote inside is doubled
+    if(field.contains(',') || field.contains('"') || field.contains('\n') || field.contains('\r'))
+    {
+        field.replace("\"", "\"\"");
+        field.prepend('"');
+        field.append('"');
+    }
+
+    return field;
+}
+
+static QJsonValue jsonValue(const QVariant &value)
+{
+    if(value.isNull())
+        return QJsonValue(QJsonValue::Null);
+
+    switch (value.type())
+    {
+    case QVariant::ByteArray:
+        return QString::fromLatin1(value.toByteArray().toBase64());
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        return value.toLongLong();
+    case QVariant::Double:
+        return value.toDouble();
+    case QVariant::Bool:
+        return value.toBool();
+    default:
+        return value.toString();
+    }
+}
+
+Exporter::Exporter(const QString &databaseName, const QString &statement,
+                   const QVariantList &values, const QString &fileName, Format format)
+    : m_databaseName(databaseName)
+    , m_statement(statement)
+    , m_values(values)
+    , m_fileName(fileName)
+    , m_format(format)
+{
+
+}
+
+Exporter::~Exporter()
+{
+    // joins a canceled export
+    if(m_thread)
+    {
+        cancel();
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+bool Exporter::formatOf(const QString &name, const QString &fileName, Exporter::Format *format)
+{
+    // an empty name takes the suffix of the file
+    const QString key = (name.isEmpty() ? QFileInfo(fileName).suffix() : name).toLower();
+    if(key == QLatin1String("csv"))
+        *format = Csv;
+    else if(key == QLatin1String("json"))
+        *format = Json;
+    else if(key == QLatin1String("jsonl") || key == QLatin1String("ndjson"))
+        *format = JsonLines;
+    else
+        return false;
+
+    return true;
+}
+
+void Exporter::start()
+{
+    if(m_thread)
+        return;
+
+    m_thread = QThread::create([this]() {
+        run();
+    });
+    m_thread->setObjectName("Exporter");
+    m_thread->start();
+}
+
+void Exporter::cancel()
+{
+    m_canceled.storeRelease(1);
+}
+
+void Exporter::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlDatabase db = Sql::addConnection(m_databaseName);
+    const bool ok = db.isOpen() ? exportRows(db)
+                                : fail("Export open error " + db.lastError().text());
+
+    const QString connectionName = db.connectionName();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+
+    qDebug(lcExporter) << m_rows << "rows exported to" << m_fileName << "in" << timer.elapsed() << "ms";
+    emit progress(m_rows);
+    emit finished(ok, ok ? m_rows : 0, m_errorString);
+}
+
+bool Exporter::exportRows(const QSqlDatabase &db)
+{
+    QSaveFile file(m_fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return fail("Can not open file '" + m_fileName + "' " + file.errorString());
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(m_statement);
+    for (const QVariant &value : m_values)
+        query.addBindValue(value);
+
+    bool ok = query.exec();
+    if(!ok)
+        fail("Export read error " + query.lastError().text());
+
+    m_buffer.reserve(BufferSize + BufferSize / 4);
+    if(ok)
+        writeHeader(query.record());
+
+    while (ok && query.next())
+    {
+        writeRow(query.record());
+        ++m_rows;
+
+        if(m_buffer.size() >= BufferSize)
+            ok = flush(&file);
+
+        if(m_rows % ProgressRows == 0)
+        {
+            if(m_canceled.loadAcquire())
+                ok = fail("Export canceled");
+            emit progress(m_rows);
+        }
+    }
+
+    if(ok && query.lastError().isValid())
+        ok = fail("Export read error " + query.lastError().text());
+    query.finish();
+
+    if(ok)
+    {
+        writeFooter();
+        ok = flush(&file);
+    }
+
+    if(ok && !file.commit())
+        ok = fail("Export write error '" + m_fileName + "' " + file.errorString());
+    if(!ok)
+        file.cancelWriting();
+
+    return ok;
+}
+
+void Exporter::writeHeader(const QSqlRecord &record)
+{
+    switch (m_format)
+    {
+    case Csv:
+        for (int i = 0; i < record.count(); ++i)
+        {
+            if(i > 0)
+                m_buffer += ',';
+            m_buffer += csvField(record.fieldName(i));
+        }
+        m_buffer += "\r\n";
+        break;
+    case Json:
+        m_buffer += '[';
+        break;
+    case JsonLines:
+        break;
+    }
+}
+
+void Exporter::writeRow(const QSqlRecord &record)
+{
+    if(m_format == Csv)
+    {
+        for (int i = 0; i < record.count(); ++i)
+        {
+            if(i > 0)
+                m_buffer += ',';
+            m_buffer += csvField(record.value(i));
+        }
+        m_buffer += "\r\n";
+        return;
+    }
+
+    QJsonObject object;
+    for (int i = 0; i < record.count(); ++i)
+        object.insert(record.fieldName(i), jsonValue(record.value(i)));
+
+    if(m_format == Json)
+        m_buffer += m_rows > 0 ? ",\n" : "\n";
+    m_buffer += QJsonDocument(object).toJson(QJsonDocument::Compact);
+    if(m_format == JsonLines)
+        m_buffer += '\n';
+}
+
+void Exporter::writeFooter()
+{
+    if(m_format == Json)
+        m_buffer += "\n]\n";
+}
+
+bool Exporter::flush(QIODevice *device)
+{
+    if(device->write(m_buffer) != m_buffer.size())
+        return fail("Export write error '" + m_fileName + "' " + device->errorString());
+
+    m_buffer.resize(0);
+    return true;
+}
+
+bool Exporter::fail(const QString &message)
+{
+    qWarning(lcExporter) << message;
+    m_errorString = message;
+
+    return false;
+}
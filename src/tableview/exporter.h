@@ -0,0 +1,98 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename exporter.h
+ * @class Exporter
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QVariant>
+
+class QIODevice;
+class QSqlDatabase;
+class QSqlRecord;
+class QThread;
+
+/**
+ * Writes the rows of a SELECT to a CSV or JSON file on a thread and a
+ * connection of its own, queries of the models are not queued behind it.
+ * The exporter lives in the thread it is created in, its signals are
+ * queued there.
+ *
+ * The query is a forward only cursor, a row is formatted into a write
+ * buffer as soon as it is read and the buffer goes to the file whenever it
+ * grows over BufferSize, memory does not grow with the number of rows.
+ * The file is replaced only when the export succeeds.
+ */
+class Exporter : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format {
+        Csv = 0,    // first line holds the column names
+        Json,       // an array of objects
+        JsonLines   // one object per line
+    };
+
+    Exporter(const QString &databaseName, const QString &statement,
+             const QVariantList &values, const QString &fileName, Format format);
+    ~Exporter();
+
+    static bool formatOf(const QString &name, const QString &fileName, Format *format);
+
+    void start();
+    void cancel();
+
+signals:
+    void progress(qint64 rows);
+    void finished(bool ok, qint64 rows, const QString &errorString);
+
+private:
+    enum {
+        BufferSize = 1024 * 1024,
+        ProgressRows = 10000
+    };
+
+    void run();
+    bool exportRows(const QSqlDatabase &db);
+    void writeHeader(const QSqlRecord &record);
+    void writeRow(const QSqlRecord &record);
+    void writeFooter();
+    bool flush(QIODevice *device);
+    bool fail(const QString &message);
+
+    QString m_databaseName;
+    QString m_statement;
+    QVariantList m_values;
+    QString m_fileName;
+    Format m_format;
+    QAtomicInt m_canceled;
+    QThread *m_thread = nullptr;
+
+    QByteArray m_buffer;
+    qint64 m_rows = 0;
+    QString m_errorString;
+};
+
+#endif // EXPORTER_H
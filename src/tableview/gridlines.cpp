@@ -0,0 +1,241 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename gridlines.cpp
+ * @class GridLines
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "gridlines.h"
+
+#include <QSGGeometryNode>
+#include <QSGFlatColorMaterial>
+#include <QVector>
+#include <qmath.h>
+
+GridLines::GridLines(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+}
+
+int GridLines::rows() const
+{
+    return m_rows;
+}
+
+void GridLines::setRows(int rows)
+{
+    if(m_rows == rows)
+        return;
+
+    m_rows = rows;
+    update();
+    emit rowsChanged();
+}
+
+int GridLines::columns() const
+{
+    return m_columns;
+}
+
+void GridLines::setColumns(int columns)
+{
+    if(m_columns == columns)
+        return;
+
+    m_columns = columns;
+    update();
+    emit columnsChanged();
+}
+
+qreal GridLines::rowHeight() const
+{
+    return m_rowHeight;
+}
+
+void GridLines::setRowHeight(qreal height)
+{
+    if(qFuzzyCompare(m_rowHeight, height))
+        return;
+
+    m_rowHeight = height;
+    update();
+    emit rowHeightChanged();
+}
+
+qreal GridLines::columnWidth() const
+{
+    return m_columnWidth;
+}
+
+void GridLines::setColumnWidth(qreal width)
+{
+    if(qFuzzyCompare(m_columnWidth, width))
+        return;
+
+    m_columnWidth = width;
+    update();
+    emit columnWidthChanged();
+}
+
+QList<qreal> GridLines::columnWidths() const
+{
+    return m_columnWidths;
+}
+
+void GridLines::setColumnWidths(const QList<qreal> &widths)
+{
+    if(m_columnWidths == widths)
+        return;
+
+    m_columnWidths = widths;
+    update();
+    emit columnWidthsChanged();
+}
+
+qreal GridLines::contentX() const
+{
+    return m_contentX;
+}
+
+void GridLines::setContentX(qreal x)
+{
+    if(qFuzzyCompare(m_contentX, x))
+        return;
+
+    m_contentX = x;
+    update();
+    emit contentXChanged();
+}
+
+qreal GridLines::contentY() const
+{
+    return m_contentY;
+}
+
+void GridLines::setContentY(qreal y)
+{
+    if(qFuzzyCompare(m_contentY, y))
+        return;
+
+    m_contentY = y;
+    update();
+    emit contentYChanged();
+}
+
+QColor GridLines::color() const
+{
+    return m_color;
+}
+
+void GridLines::setColor(const QColor &color)
+{
+    if(m_color == color)
+        return;
+
+    m_color = color;
+    update();
+    emit colorChanged();
+}
+
+QSGNode *GridLines::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    QSGGeometryNode *node = static_cast<QSGGeometryNode *>(oldNode);
+    if(!node)
+    {
+        node = new QSGGeometryNode();
+        QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawLines);
+        geometry->setLineWidth(1);
+        node->setGeometry(geometry);
+        node->setFlag(QSGNode::OwnsGeometry);
+        node->setMaterial(new QSGFlatColorMaterial());
+        node->setFlag(QSGNode::OwnsMaterial);
+    }
+
+    QSGFlatColorMaterial *material = static_cast<QSGFlatColorMaterial *>(node->material());
+    if(material->color() != m_color)
+    {
+        material->setColor(m_color);
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+
+    const qreal w = width();
+    const qreal h = height();
+
+    // column borders inside the view
+    QVector<qreal> xs;
+    qreal x = 0;
+    for (int column = 0; column <= m_columns; ++column)
+    {
+        const qreal pos = x - m_contentX;
+        if(pos > w)
+            break;
+        if(pos >= 0)
+            xs.append(pos);
+        if(column < m_columns)
+            x += widthOf(column);
+    }
+    const qreal right = qMin(w, x - m_contentX);
+
+    // rows have the same height, only the visible borders are computed
+    QVector<qreal> ys;
+    if(m_rowHeight > 0)
+    {
+        const int first = qMax(0, int(qCeil(m_contentY / m_rowHeight)));
+        const int last = qMin(m_rows, int(qFloor((m_contentY + h) / m_rowHeight)));
+        for (int row = first; row <= last; ++row)
+            ys.append(row * m_rowHeight - m_contentY);
+    }
+    const qreal bottom = qMin(h, m_rows * m_rowHeight - m_contentY);
+
+    QSGGeometry *geometry = node->geometry();
+    geometry->allocate((xs.count() + ys.count()) * 2);
+    QSGGeometry::Point2D *vertices = geometry->vertexDataAsPoint2D();
+
+    int i = 0;
+    for (qreal pos : xs)
+    {
+        vertices[i++].set(float(pos + 0.5), 0);
+        vertices[i++].set(float(pos + 0.5), float(qMax<qreal>(0, bottom)));
+    }
+    for (qreal pos : ys)
+    {
+        vertices[i++].set(0, float(pos + 0.5));
+        vertices[i++].set(float(qMax<qreal>(0, right)), float(pos + 0.5));
+    }
+
+    node->markDirty(QSGNode::DirtyGeometry);
+    return node;
+}
+
+void GridLines::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if(newGeometry.size() != oldGeometry.size())
+        update();
+}
+
+qreal GridLines::widthOf(int column) const
+{
+    return column < m_columnWidths.count() ? m_columnWidths.at(column) : m_columnWidth;
+}
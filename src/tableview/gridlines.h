@@ -0,0 +1,99 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename gridlines.h
+ * @class GridLines
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef GRIDLINES_H
+#define GRIDLINES_H
+
+#include <QQuickItem>
+#include <QColor>
+
+/**
+ * Draws the grid lines of the visible part of a table in one scene graph
+ * node, so cell delegates do not need border items of their own.
+ */
+class GridLines : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(int rows READ rows WRITE setRows NOTIFY rowsChanged)
+    Q_PROPERTY(int columns READ columns WRITE setColumns NOTIFY columnsChanged)
+    Q_PROPERTY(qreal rowHeight READ rowHeight WRITE setRowHeight NOTIFY rowHeightChanged)
+    Q_PROPERTY(qreal columnWidth READ columnWidth WRITE setColumnWidth NOTIFY columnWidthChanged)
+    Q_PROPERTY(QList<qreal> columnWidths READ columnWidths WRITE setColumnWidths NOTIFY columnWidthsChanged)
+    Q_PROPERTY(qreal contentX READ contentX WRITE setContentX NOTIFY contentXChanged)
+    Q_PROPERTY(qreal contentY READ contentY WRITE setContentY NOTIFY contentYChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+public:
+    explicit GridLines(QQuickItem *parent = nullptr);
+
+    int rows() const;
+    void setRows(int rows);
+
+    int columns() const;
+    void setColumns(int columns);
+
+    qreal rowHeight() const;
+    void setRowHeight(qreal height);
+
+    qreal columnWidth() const;
+    void setColumnWidth(qreal width);
+
+    QList<qreal> columnWidths() const;
+    void setColumnWidths(const QList<qreal> &widths);
+
+    qreal contentX() const;
+    void setContentX(qreal x);
+
+    qreal contentY() const;
+    void setContentY(qreal y);
+
+    QColor color() const;
+    void setColor(const QColor &color);
+
+signals:
+    void rowsChanged();
+    void columnsChanged();
+    void rowHeightChanged();
+    void columnWidthChanged();
+    void columnWidthsChanged();
+    void contentXChanged();
+    void contentYChanged();
+    void colorChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    qreal widthOf(int column) const;
+
+    int m_rows = 0;
+    int m_columns = 0;
+    qreal m_rowHeight = 32;
+    qreal m_columnWidth = 100;
+    QList<qreal> m_columnWidths;
+    qreal m_contentX = 0;
+    qreal m_contentY = 0;
+    QColor m_color = QColor("#dddddd");
+};
+
+#endif // GRIDLINES_H
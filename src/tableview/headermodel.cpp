@@ -0,0 +1,131 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename headermodel.cpp
+ * @class HeaderModel
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "headermodel.h"
+
+HeaderModel::HeaderModel(QAbstractItemModel *source, Qt::Orientation orientation, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_source(source)
+    , m_orientation(orientation)
+{
+    connect(m_source, &QAbstractItemModel::modelAboutToBeReset, this, &HeaderModel::beginResetModel);
+    connect(m_source, &QAbstractItemModel::modelReset, this, &HeaderModel::endResetModel);
+    connect(m_source, &QAbstractItemModel::layoutAboutToBeChanged, this, [this]() { beginResetModel(); });
+    connect(m_source, &QAbstractItemModel::layoutChanged, this, [this]() { endResetModel(); });
+    connect(m_source, &QAbstractItemModel::headerDataChanged, this, &HeaderModel::onHeaderDataChanged);
+
+    // the sections of the header are the rows or the columns of the source
+    if(m_orientation == Qt::Vertical)
+    {
+        connect(m_source, &QAbstractItemModel::rowsAboutToBeInserted, this,
+                [this](const QModelIndex &parent, int first, int last) {
+            if(!parent.isValid())
+                beginInsertRows(QModelIndex(), first, last);
+        });
+        connect(m_source, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &parent, int first) {
+            if(!parent.isValid())
+            {
+                endInsertRows();
+                renumberFrom(first);
+            }
+        });
+        connect(m_source, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                [this](const QModelIndex &parent, int first, int last) {
+            if(!parent.isValid())
+                beginRemoveRows(QModelIndex(), first, last);
+        });
+        connect(m_source, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &parent, int first) {
+            if(!parent.isValid())
+            {
+                endRemoveRows();
+                renumberFrom(first);
+            }
+        });
+    }
+    else
+    {
+        connect(m_source, &QAbstractItemModel::columnsAboutToBeInserted, this,
+                [this](const QModelIndex &parent, int first, int last) {
+            if(!parent.isValid())
+                beginInsertRows(QModelIndex(), first, last);
+        });
+        connect(m_source, &QAbstractItemModel::columnsInserted, this, [this](const QModelIndex &parent) {
+            if(!parent.isValid())
+                endInsertRows();
+        });
+        connect(m_source, &QAbstractItemModel::columnsAboutToBeRemoved, this,
+                [this](const QModelIndex &parent, int first, int last) {
+            if(!parent.isValid())
+                beginRemoveRows(QModelIndex(), first, last);
+        });
+        connect(m_source, &QAbstractItemModel::columnsRemoved, this, [this](const QModelIndex &parent) {
+            if(!parent.isValid())
+                endRemoveRows();
+        });
+    }
+}
+
+int HeaderModel::rowCount(const QModelIndex &parent) const
+{
+    if(parent.isValid())
+        return 0;
+
+    return m_orientation == Qt::Vertical ? m_source->rowCount() : m_source->columnCount();
+}
+
+QVariant HeaderModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid())
+        return QVariant();
+
+    return m_source->headerData(index.row(), m_orientation, role);
+}
+
+QHash<int, QByteArray> HeaderModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(Qt::DisplayRole, QByteArrayLiteral("display"));
+    return roles;
+}
+
+Qt::Orientation HeaderModel::orientation() const
+{
+    return m_orientation;
+}
+
+void HeaderModel::onHeaderDataChanged(Qt::Orientation orientation, int first, int last)
+{
+    if(orientation != m_orientation || first > last)
+        return;
+
+    emit dataChanged(index(first), index(last));
+}
+
+void HeaderModel::renumberFrom(int first)
+{
+    // the delegates moved by the rows keep the number read before
+    const int count = rowCount();
+    if(first < count)
+        emit dataChanged(index(first), index(count - 1));
+}
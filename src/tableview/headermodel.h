@@ -0,0 +1,55 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename headermodel.h
+ * @class HeaderModel
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef HEADERMODEL_H
+#define HEADERMODEL_H
+
+#include <QAbstractListModel>
+
+/**
+ * A list of the horizontal or vertical section headers of a table model,
+ * for a ListView that creates delegates only for the visible sections.
+ */
+class HeaderModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit HeaderModel(QAbstractItemModel *source, Qt::Orientation orientation, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    Qt::Orientation orientation() const;
+
+private:
+    void onHeaderDataChanged(Qt::Orientation orientation, int first, int last);
+    // the rows are numbered by the vertical header, from first on they
+    // have another number after rows came or went
+    void renumberFrom(int first);
+
+    QAbstractItemModel *m_source;
+    Qt::Orientation m_orientation;
+};
+
+#endif // HEADERMODEL_H
@@ -0,0 +1,401 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename importer.cpp
+ * @class Importer
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "importer.h"
+#include "sql.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThread>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcImporter, "app.Importer")
+
+static inline bool isSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+Importer::Importer(const QString &databaseName, const QString &tableName,
+                   const QString &fileName, Format format)
+    : m_databaseName(databaseName)
+    , m_tableName(tableName)
+    , m_fileName(fileName)
+    , m_format(format)
+{
+
+}
+
+Importer::~Importer()
+{
+    // joins a canceled import
+    if(m_thread)
+    {
+        cancel();
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+bool Importer::formatOf(const QString &name, const QString &fileName, Importer::Format *format)
+{
+    // an empty name takes the suffix of the file
+    const QString key = (name.isEmpty() ? QFileInfo(fileName).suffix() : name).toLower();
+    if(key == QLatin1String("csv"))
+        *format = Csv;
+    else if(key == QLatin1String("json") || key == QLatin1String("jsonl") || key == QLatin1String("ndjson"))
+        *format = Json;
+    else
+        return false;
+
+    return true;
+}
+
+void Importer::start()
+{
+    if(m_thread)
+        return;
+
+    m_thread = QThread::create([this]() {
+        run();
+    });
+    m_thread->setObjectName("Importer");
+    m_thread->start();
+}
+
+void Importer::cancel()
+{
+    m_canceled.storeRelease(1);
+}
+
+void Importer::run()
+{
+    m_timer.start();
+    m_db = Sql::addConnection(m_databaseName);
+    const bool ok = m_db.isOpen() ? importFile()
+                                  : fail("Import open error " + m_db.lastError().text());
+
+    const QString connectionName = m_db.connectionName();
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+
+    const qint64 elapsed = qMax<qint64>(1, m_timer.elapsed());
+    qDebug(lcImporter) << m_rows << "rows imported from" << m_fileName << "in" << elapsed << "ms";
+    emit progress(m_rows, 1.0, m_rows * 1000.0 / elapsed);
+    // rows of the batches committed before a failure stay imported
+    emit finished(ok, ok ? m_rows : m_rows - m_uncommitted, m_errorString);
+}
+
+bool Importer::importFile()
+{
+    QFile file(m_fileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return fail("Can not open file '" + m_fileName + "' " + file.errorString());
+
+    m_size = file.size();
+    uchar *data = m_size > 0 ? file.map(0, m_size) : nullptr;
+    if(m_size > 0 && !data)
+        return fail("Can not map file '" + m_fileName + "' " + file.errorString());
+
+    m_begin = reinterpret_cast<const char *>(data);
+    const char *begin = m_begin;
+    const char *end = m_begin + m_size;
+    if(m_size >= 3 && qstrncmp(begin, "\xEF\xBB\xBF", 3) == 0)
+        begin += 3;
+
+    bool ok = m_db.transaction();
+    if(!ok)
+        fail("Import begin error " + m_db.lastError().text());
+
+    ok = ok && (m_format == Csv ? readCsv(begin, end) : readJson(begin, end));
+    ok = ok && flush(true);
+    if(ok && !m_db.commit())
+        ok = fail("Import commit error " + m_db.lastError().text());
+    if(!ok)
+        m_db.rollback();
+
+    file.unmap(data);
+
+    return ok;
+}
+
+bool Importer::readCsv(const char *begin, const char *end)
+{
+    const char *p = begin;
+    bool header = true;
+    QVariantList fields;
+    QByteArray quoted;
+    while (p < end)
+    {
+        fields.clear();
+        forever
+        {
+            if(p < end && *p == '"')
+            {
+                // "" inside a quoted field is one quote
+                quoted.clear();
+                for (++p; p < end; ++p)
+                {
+                    if(*p == '"')
+                    {
+                        if(p + 1 < end && p[1] == '"')
+                            ++p;
+                        else
+                            break;
+                    }
+                    quoted += *p;
+                }
+                if(p < end)
+                    ++p;
+                while (p < end && *p != ',' && *p != '\n' && *p != '\r')
+                    ++p;
+                fields.append(quoted.isEmpty() ? QStringLiteral("") : QString::fromUtf8(quoted));
+            }
+            else
+            {
+                const char *start = p;
+                while (p < end && *p != ',' && *p != '\n' && *p != '\r')
+                    ++p;
+                // an empty field without quotes is NULL, "" is an empty text
+                fields.append(p > start ? QVariant(QString::fromUtf8(start, int(p - start))) : QVariant());
+            }
+
+            if(p < end && *p == ',')
+            {
+                ++p;
+                continue;
+            }
+            if(p < end && *p == '\r')
+                ++p;
+            if(p < end && *p == '\n')
+                ++p;
+            break;
+        }
+
+        // blank line
+        if(fields.count() == 1 && fields.at(0).isNull())
+            continue;
+
+        if(header)
+        {
+            QStringList names;
+            for (const QVariant &field : fields)
+                names << field.toString().trimmed();
+            if(!setColumns(names))
+                return false;
+            header = false;
+            continue;
+        }
+
+        if(!append(fields, p))
+            return false;
+    }
+
+    return true;
+}
+
+bool Importer::readJson(const char *begin, const char *end)
+{
+    // the objects are cut out of the text and parsed one by one, a
+    // top level array is entered, otherwise objects follow each other
+    const char *p = begin;
+    while (p < end && isSpace(*p))
+        ++p;
+
+    const int base = p < end && *p == '[' ? 1 : 0;
+    int depth = 0;
+    bool string = false;
+    const char *object = nullptr;
+    for (; p < end; ++p)
+    {
+        const char ch = *p;
+        if(string)
+        {
+            if(ch == '\\')
+                ++p;
+            else if(ch == '"')
+                string = false;
+            continue;
+        }
+
+        switch (ch)
+        {
+        case '"':
+            string = true;
+            break;
+        case '{':
+        case '[':
+            if(ch == '{' && depth == base)
+                object = p;
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            --depth;
+            if(ch == '}' && depth == base && object)
+            {
+                if(!readObject(object, p + 1))
+                    return false;
+                object = nullptr;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool Importer::readObject(const char *begin, const char *end)
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(begin, int(end - begin)), &error);
+    if(!doc.isObject())
+        return fail("Import parse error at " + QString::number(begin - m_begin) + " " + error.errorString());
+
+    const QJsonObject object = doc.object();
+    if(m_columns.isEmpty() && !setColumns(object.keys()))
+        return false;
+
+    QVariantList values;
+    values.reserve(m_columns.count());
+    for (const QString &column : m_columns)
+        values << object.value(column).toVariant();
+
+    // values are already in column order
+    return append(values, end);
+}
+
+bool Importer::setColumns(const QStringList &names)
+{
+    const QSqlRecord record = m_db.record(m_tableName);
+    for (int i = 0; i < names.count(); ++i)
+    {
+        if(record.indexOf(names.at(i)) < 0)
+        {
+            qDebug(lcImporter) << "Ignore column" << names.at(i);
+            continue;
+        }
+
+        m_columns << names.at(i);
+        m_sources << (m_format == Csv ? i : m_sources.count());
+    }
+
+    if(m_columns.isEmpty())
+        return fail("No column of '" + m_fileName + "' found in table " + m_tableName);
+
+    m_rowsPerStatement = qMax(1, int(MaxVariables) / m_columns.count());
+    m_insert = insertStatement(m_rowsPerStatement);
+    m_values.reserve(m_rowsPerStatement * m_columns.count());
+    return true;
+}
+
+bool Importer::append(const QVariantList &values, const char *pos)
+{
+    for (int source : m_sources)
+        m_values << values.value(source);
+    ++m_pending;
+
+    if(m_pending >= m_rowsPerStatement && !flush(false))
+        return false;
+
+    const qint64 elapsed = m_timer.elapsed();
+    if(elapsed - m_lastProgress >= ProgressInterval)
+    {
+        m_lastProgress = elapsed;
+        emit progress(m_rows, m_size > 0 ? qreal(pos - m_begin) / m_size : 1.0,
+                      m_rows * 1000.0 / qMax<qint64>(1, elapsed));
+    }
+
+    return true;
+}
+
+bool Importer::flush(bool all)
+{
+    if(m_canceled.loadAcquire())
+        return fail("Import canceled");
+
+    if(m_pending > 0)
+    {
+        QSqlQuery query = Sql::prepare(m_pending == m_rowsPerStatement
+                                       ? m_insert : insertStatement(m_pending), m_db);
+        for (const QVariant &value : m_values)
+            query.addBindValue(value);
+
+        if(!query.exec())
+            return fail("Import insert error " + query.lastError().text());
+
+        query.finish();
+        m_rows += m_pending;
+        m_uncommitted += m_pending;
+        m_values.clear();
+        m_pending = 0;
+    }
+
+    // bound the journal of one transaction
+    if(!all && m_uncommitted >= TransactionRows)
+    {
+        m_uncommitted = 0;
+        if(!m_db.commit() || !m_db.transaction())
+            return fail("Import commit error " + m_db.lastError().text());
+    }
+
+    return true;
+}
+
+QString Importer::insertStatement(int rows) const
+{
+    const QSqlDriver *driver = m_db.driver();
+    QStringList fields;
+    for (const QString &column : m_columns)
+        fields << driver->escapeIdentifier(column, QSqlDriver::FieldName);
+
+    QStringList marks;
+    for (int i = 0; i < m_columns.count(); ++i)
+        marks << QStringLiteral("?");
+    const QString tuple = "(" + marks.join(",") + ")";
+
+    QStringList tuples;
+    for (int i = 0; i < rows; ++i)
+        tuples << tuple;
+
+    return "INSERT INTO " + driver->escapeIdentifier(m_tableName, QSqlDriver::TableName)
+            + " (" + fields.join(", ") + ") VALUES " + tuples.join(",");
+}
+
+bool Importer::fail(const QString &message)
+{
+    qWarning(lcImporter) << message;
+    m_errorString = message;
+
+    return false;
+}
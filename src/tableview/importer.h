@@ -0,0 +1,112 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename importer.h
+ * @class Importer
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class QThread;
+
+/**
+ * Imports a CSV or JSON file into a table on a thread and a connection of
+ * its own, queries of the models are not queued behind it. The importer
+ * lives in the thread it is created in, its signals are queued there.
+ *
+ * The file is memory mapped and parsed in place. Rows are inserted by
+ * multi-row prepared INSERTs, as many rows per statement as the 999 bind
+ * variables of SQLite allow, and committed every TransactionRows rows.
+ * Columns of the file that the table does not have are ignored.
+ */
+class Importer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format {
+        Csv = 0,    // first line holds the column names
+        Json        // an array of objects, or one object per line
+    };
+
+    Importer(const QString &databaseName, const QString &tableName,
+             const QString &fileName, Format format);
+    ~Importer();
+
+    static bool formatOf(const QString &name, const QString &fileName, Format *format);
+
+    void start();
+    void cancel();
+
+signals:
+    void progress(qint64 rows, qreal fraction, qreal rowsPerSecond);
+    void finished(bool ok, qint64 rows, const QString &errorString);
+
+private:
+    enum {
+        MaxVariables = 999,
+        TransactionRows = 100000,
+        ProgressInterval = 100  // milliseconds
+    };
+
+    void run();
+    bool importFile();
+    bool readCsv(const char *begin, const char *end);
+    bool readJson(const char *begin, const char *end);
+    bool readObject(const char *begin, const char *end);
+
+    bool setColumns(const QStringList &names);
+    bool append(const QVariantList &values, const char *pos);
+    bool flush(bool all);
+    QString insertStatement(int rows) const;
+    bool fail(const QString &message);
+
+    QString m_databaseName;
+    QString m_tableName;
+    QString m_fileName;
+    Format m_format;
+    QAtomicInt m_canceled;
+    QThread *m_thread = nullptr;
+
+    QSqlDatabase m_db;
+    QStringList m_columns;
+    QVector<int> m_sources;     // index in the file for each column
+    int m_rowsPerStatement = 1;
+    QString m_insert;           // for m_rowsPerStatement rows
+    QVariantList m_values;
+    int m_pending = 0;
+    int m_uncommitted = 0;
+    qint64 m_rows = 0;
+
+    const char *m_begin = nullptr;
+    qint64 m_size = 0;
+    QElapsedTimer m_timer;
+    qint64 m_lastProgress = 0;
+    QString m_errorString;
+};
+
+#endif // IMPORTER_H
@@ -1,7 +1,8 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 
-#include "tablemodel.h"
+#include "qmltypes.h"
+#include "sql.h"
 
 int main(int argc, char *argv[])
 {
@@ -9,7 +10,11 @@ int main(int argc, char *argv[])
 
     QGuiApplication app(argc, argv);
 
-    qmlRegisterType<TableModel>("Macai.App", 1, 0, "SqlTableModel");
+    // optional SQLite connection profile, see Sql::loadProfile()
+    Sql::loadProfile(qEnvironmentVariable("TABLEVIEW_SQL_PROFILE",
+                                          QCoreApplication::applicationDirPath() + "/sql.ini"));
+
+    QmlTypes::registerTypes();
 
     QQmlApplicationEngine engine;
     const QUrl url(QStringLiteral("qrc:/main.qml"));
@@ -1,6 +1,6 @@
-import QtQuick 2.12
-import QtQuick.Window 2.12
-import QtQuick.Controls 2.12
+import QtQuick 2.15
+import QtQuick.Window 2.15
+import QtQuick.Controls 2.15
 import Macai.App 1.0
 
 Window {
@@ -9,99 +9,131 @@ Window {
     width: 1200
     height: 600
     title: qsTr("QML TableView example")
-    onWidthChanged: {
-        tableView.forceLayout()
+
+    Button {
+        id: cornerButton
+        z: 3
+        text: "#"
+        width: 30
+        height: 32
+    }
+
+    // headers are list views over the header models of the table model,
+    // only the visible sections get a delegate. Sections scrolled out are
+    // pooled and handed out again, no cache buffer creates sections ahead
+    ListView {
+        id: horizontalHeader
+        anchors.left: cornerButton.right
+        anchors.right: parent.right
+        height: cornerButton.height
+        orientation: ListView.Horizontal
+        interactive: false
+        clip: true
+        reuseItems: true
+        cacheBuffer: 0
+        contentX: tableView.contentX
+        model: tableModel.horizontalHeader
+
+        delegate: Button {
+            width: tableView.columnWidths[index]
+            height: horizontalHeader.height
+            text: tableModel.sortColumn !== index ? display
+                : display + (tableModel.sortOrder === Qt.AscendingOrder ? " ▲" : " ▼")
+            // a reused section starts without the press of its last one
+            ListView.onReused: down = undefined
+            onClicked: {
+                tableModel.sortOrder = tableModel.sortColumn === index && tableModel.sortOrder === Qt.AscendingOrder
+                        ? Qt.DescendingOrder : Qt.AscendingOrder
+                tableModel.sortColumn = index
+            }
+        }
+    }
+
+    ListView {
+        id: verticalHeader
+        anchors.top: cornerButton.bottom
+        anchors.bottom: parent.bottom
+        width: cornerButton.width
+        interactive: false
+        clip: true
+        reuseItems: true
+        cacheBuffer: 0
+        contentY: tableView.contentY
+        model: tableModel.verticalHeader
+
+        delegate: Button {
+            width: verticalHeader.width
+            height: tableView.rowHeight
+            text: display
+            ListView.onReused: down = undefined
+        }
     }
 
     TableView {
         id: tableView
-        anchors.fill: parent
+        objectName: "tableView"
+        anchors.left: verticalHeader.right
+        anchors.top: horizontalHeader.bottom
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
         columnSpacing: 0
         rowSpacing: 0
         clip: true
-        leftMargin: vericalHeader.implicitWidth
-        topMargin: horizontalHeader.implicitHeight
-        rowHeightProvider: function (row) { return 32; }
-        columnWidthProvider: function (column) {
-            return Math.max(1, (tableView.width - leftMargin) / tableView.columns)
-        }
+
+        // widths are computed by the model, the layout is redone only
+        // when one of them changes
+        readonly property real rowHeight: 32
+        readonly property var columnWidths: tableModel.geometry.widths
+        onColumnWidthsChanged: forceLayout()
+        rowHeightProvider: function (row) { return rowHeight }
+        columnWidthProvider: function (column) { return columnWidths[column] }
 
         ScrollIndicator.horizontal: ScrollIndicator { }
         ScrollIndicator.vertical: ScrollIndicator { }
 
         model: SqlTableModel {
             id: tableModel
+            fetchMode: SqlTableModel.WindowedFetch
+            asynchronous: true
+            // the scroll indicators span the estimated rows at once
+            countStrategy: SqlTableModel.EstimatedCount
+            geometry.autoSize: true
+            geometry.viewWidth: tableView.width
+            Component.onCompleted: metrics.window = window
         }
 
-        delegate: Rectangle {
-            id: cellItem
-
-            implicitWidth: content.implicitHeight
-            implicitHeight: 30
-            Rectangle { anchors.left: parent.left; height: parent.height; width: 1; color: "#dddddd"}
-            Rectangle { anchors.top: parent.top; width: parent.width; height: 1; color: "#dddddd"}
-            Rectangle { anchors.right: parent.right; height: parent.height; width: 1; color: "#dddddd"; visible: model.column === tableView.columns -1 }
-            Rectangle { anchors.bottom: parent.bottom; width: parent.width; height: 1; color: "#dddddd"; visible: model.row === tableView.rows - 1 }
-
-            Text {
-                id: content
-                anchors.fill: parent
-                verticalAlignment: Text.AlignVCenter
-                horizontalAlignment: Text.AlignLeft
-                padding: 4
-                clip: true
-                text: tableModel.data(tableModel.index(row, column))
-            }
-
-            MouseArea{
-                anchors.fill: parent
-                hoverEnabled: true
-                onEntered: cellItem.color = "lightsteelblue"
-                onExited: cellItem.color = "#ffffff"
-                onClicked: {
-                    console.log("(", row, ",", column ,")", "[", cellItem.x, ",",cellItem.y, "]")
-                    console.log(tableModel.rowCount(), tableModel.columnCount())
-                }
-            }
+        // pooled delegates are handed out again on scrolling, the cell
+        // only binds the display role and the grid is drawn once on top.
+        // A pooled cell is hidden and drops its text, a dataChanged of the
+        // row it showed lays out nothing until the cell is reused
+        reuseItems: true
+        delegate: Text {
+            property bool pooled: false
+            TableView.onPooled: pooled = true
+            TableView.onReused: pooled = false
+            text: pooled || display === undefined ? "" : display
+            verticalAlignment: Text.AlignVCenter
+            horizontalAlignment: Text.AlignLeft
+            padding: 4
+            elide: Text.ElideRight
         }
 
-        Button {
-            z: 3
-            y: tableView.contentY
-            x: tableView.contentX
-            text: "#"
-            width: tableView.leftMargin
-            height: tableView.topMargin
-        }
-
-        Row {
-            id: horizontalHeader
-            y: tableView.contentY
-            z: 2
-            Repeater {
-                model: tableView.columns > 0 ? tableView.columns : 1
-
-                Button {
-                    width: tableView.columnWidthProvider(index)
-                    height: tableView.rowHeightProvider(index)
-                    text: tableModel.headerData(index, Qt.Horizontal)
-                }
-            }
+        GridLines {
+            parent: tableView
+            anchors.fill: parent
+            z: 1
+            rows: tableView.rows
+            columns: tableView.columns
+            rowHeight: tableView.rowHeight
+            columnWidths: tableView.columnWidths
+            contentX: tableView.contentX
+            contentY: tableView.contentY
         }
+    }
 
-        Column {
-            id: vericalHeader
-            x: tableView.contentX
-            z: 2
-            Repeater {
-                model: tableView.rows > 0 ? tableView.rows : 1
-                Button {
-                    width: 30
-                    height: tableView.rowHeightProvider(index)
-                    text: tableModel.headerData(index, Qt.Vertical)
-                }
-            }
-        }
+    BusyIndicator {
+        anchors.centerIn: parent
+        running: tableModel.loading
     }
 
     Component {
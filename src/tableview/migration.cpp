@@ -0,0 +1,405 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename migration.cpp
+ * @class Migration
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "migration.h"
+#include "schemacache.h"
+#include "sql.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+
+/**
+ * The state machine of sqlite3_complete(), fed one character at a time.
+ * Qt's bundled SQLite is built with SQLITE_OMIT_COMPLETE, so it is not
+ * available from the driver. Semicolons inside literals, identifiers and
+ * comments, and the ones of a CREATE TRIGGER body, do not end a statement.
+ */
+class StatementScanner
+{
+public:
+    // returns true when ch completes a statement
+    bool scan(QChar ch)
+    {
+        switch (m_lex)
+        {
+        case LineComment:
+            if(ch == QLatin1Char('\n'))
+                m_lex = Plain;
+            return false;
+        case BlockComment:
+            if(m_last == QLatin1Char('*') && ch == QLatin1Char('/'))
+                m_lex = Plain;
+            m_last = ch;
+            return false;
+        case Quoted:
+            // a doubled quote closes and reopens, which is the same token
+            if(ch == m_quote)
+                m_lex = Plain;
+            return false;
+        case Word:
+            if(isIdentifier(ch))
+            {
+                if(m_word.size() < MaxKeyword)
+                    m_word += ch;
+                else
+                    m_word = QLatin1String("_");
+                return false;
+            }
+            m_lex = Plain;
+            feed(keyword(m_word));
+            m_word.clear();
+            break;
+        case Plain:
+            break;
+        }
+
+        if(!m_pending.isNull())
+        {
+            const QChar pending = m_pending;
+            m_pending = QChar();
+            if(pending == QLatin1Char('-') && ch == QLatin1Char('-'))
+            {
+                m_lex = LineComment;
+                feed(Space);
+                return false;
+            }
+            if(pending == QLatin1Char('/') && ch == QLatin1Char('*'))
+            {
+                m_lex = BlockComment;
+                m_last = QChar();
+                feed(Space);
+                return false;
+            }
+            feed(Other);
+        }
+
+        switch (ch.unicode())
+        {
+        case ';':
+            feed(Semi);
+            return m_state == Start;
+        case ' ': case '\t': case '\n': case '\r': case '\f':
+            feed(Space);
+            return false;
+        case '-': case '/':
+            m_pending = ch;
+            return false;
+        case '\'': case '"': case '`':
+            m_lex = Quoted;
+            m_quote = ch;
+            feed(Other);
+            return false;
+        case '[':
+            m_lex = Quoted;
+            m_quote = QLatin1Char(']');
+            feed(Other);
+            return false;
+        default:
+            break;
+        }
+
+        if(isIdentifier(ch))
+        {
+            m_lex = Word;
+            m_word = ch;
+            return false;
+        }
+
+        feed(Other);
+        return false;
+    }
+
+    // true when ch left a complete statement and nothing is open
+    bool isComplete() const
+    {
+        return m_lex == Plain && m_pending.isNull() && m_state == Start;
+    }
+
+    // true when anything but white space and comments was read
+    bool hasText() const
+    {
+        return m_text;
+    }
+
+    void reset()
+    {
+        *this = StatementScanner();
+    }
+
+private:
+    enum Lex { Plain, Word, Quoted, LineComment, BlockComment };
+    enum Token { Semi, Space, Other, Explain, Create, Temp, Trigger, End };
+    enum State { Invalid, Start, Normal, InExplain, InCreate, InTrigger, TriggerSemi, TriggerEnd };
+    enum { MaxKeyword = 9 };
+
+    static bool isIdentifier(QChar ch)
+    {
+        return ch.isLetterOrNumber() || ch == QLatin1Char('_') || ch == QLatin1Char('$')
+                || ch.unicode() > 0x7f;
+    }
+
+    static Token keyword(const QString &word)
+    {
+        if(word.compare(QLatin1String("EXPLAIN"), Qt::CaseInsensitive) == 0)
+            return Explain;
+        if(word.compare(QLatin1String("CREATE"), Qt::CaseInsensitive) == 0)
+            return Create;
+        if(word.compare(QLatin1String("TEMP"), Qt::CaseInsensitive) == 0
+                || word.compare(QLatin1String("TEMPORARY"), Qt::CaseInsensitive) == 0)
+            return Temp;
+        if(word.compare(QLatin1String("TRIGGER"), Qt::CaseInsensitive) == 0)
+            return Trigger;
+        if(word.compare(QLatin1String("END"), Qt::CaseInsensitive) == 0)
+            return End;
+
+        return Other;
+    }
+
+    void feed(Token token)
+    {
+        static const quint8 transitions[8][8] = {
+            /*                  SEMI  WS  OTHER EXPLAIN CREATE TEMP TRIGGER END */
+            /* Invalid     */ {    1,  0,     2,      3,     4,   2,      2,  2 },
+            /* Start       */ {    1,  1,     2,      3,     4,   2,      2,  2 },
+            /* Normal      */ {    1,  2,     2,      2,     2,   2,      2,  2 },
+            /* InExplain   */ {    1,  3,     3,      2,     4,   2,      2,  2 },
+            /* InCreate    */ {    1,  4,     2,      2,     2,   4,      5,  2 },
+            /* InTrigger   */ {    6,  5,     5,      5,     5,   5,      5,  5 },
+            /* TriggerSemi */ {    6,  6,     5,      5,     5,   5,      5,  7 },
+            /* TriggerEnd  */ {    1,  7,     5,      5,     5,   5,      5,  5 },
+        };
+
+        if(token != Space && token != Semi)
+            m_text = true;
+        m_state = State(transitions[m_state][token]);
+    }
+
+    Lex m_lex = Plain;
+    State m_state = Invalid;
+    QChar m_quote;
+    QChar m_last;
+    QChar m_pending;
+    QString m_word;
+    bool m_text = false;
+};
+
+/**
+ * Reads the statements of a file one at a time, the file is never loaded
+ * as a whole.
+ */
+class StatementReader
+{
+public:
+    explicit StatementReader(QIODevice *device)
+        : m_stream(device)
+    {
+        m_stream.setCodec("UTF-8");
+    }
+
+    bool next(QString *statement)
+    {
+        forever
+        {
+            if(m_pos >= m_line.size())
+            {
+                if(m_stream.atEnd())
+                    break;
+
+                m_line = m_stream.readLine() + QLatin1Char('\n');
+                m_pos = 0;
+            }
+
+            const QChar ch = m_line.at(m_pos++);
+            m_statement += ch;
+            if(!m_scanner.scan(ch))
+                continue;
+
+            if(take(statement))
+                return true;
+        }
+
+        // the last statement may miss its semicolon
+        return take(statement);
+    }
+
+private:
+    bool take(QString *statement)
+    {
+        const bool text = m_scanner.hasText();
+        if(text)
+            *statement = m_statement.trimmed();
+
+        m_statement.clear();
+        m_scanner.reset();
+
+        return text;
+    }
+
+    QTextStream m_stream;
+    StatementScanner m_scanner;
+    QString m_line;
+    int m_pos = 0;
+    QString m_statement;
+};
+
+}
+
+Migration::Migration(const QSqlDatabase &db)
+    : m_db(db)
+{
+
+}
+
+bool Migration::run(const QString &directory)
+{
+    if(!prepare())
+        return false;
+
+    const QFileInfoList files = QDir(directory).entryInfoList(QStringList() << "*.sql",
+                                                               QDir::Files, QDir::Name);
+    bool changed = false;
+    bool ok = true;
+    for (const QFileInfo &file : files)
+    {
+        const QString version = file.completeBaseName();
+        if(isApplied(version))
+            continue;
+
+        changed = true;
+        if(!apply(version, file.filePath()))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    // the schema changed under the cached statements
+    if(changed)
+    {
+        Sql::invalidateStatements();
+        SchemaCache::invalidate(m_db);
+    }
+
+    return ok;
+}
+
+bool Migration::apply(const QString &version, const QString &file)
+{
+    if(!prepare())
+        return false;
+
+    QFile sqlFile(file);
+    if(!sqlFile.open(QIODevice::ReadOnly))
+        return fail("Can not open file '" + file + "' " + sqlFile.errorString());
+
+    if(!m_db.transaction())
+        return fail("Migration begin error '" + file + "' " + m_db.lastError().text());
+
+    StatementReader reader(&sqlFile);
+    QString statement;
+    QSqlQuery query(m_db);
+    while (reader.next(&statement))
+    {
+        if(!query.exec(statement))
+        {
+            const QString message = "Migration up error '" + file + "' " + query.lastError().text();
+            query.finish();
+            m_db.rollback();
+            qCritical() << statement;
+
+            return fail(message);
+        }
+    }
+    query.finish();
+
+    query.prepare("INSERT INTO schema_migrations (version) VALUES (?)");
+    query.addBindValue(version);
+    if(!query.exec() || !m_db.commit())
+    {
+        const QString message = "Migration commit error '" + file + "' "
+                + (query.lastError().isValid() ? query.lastError() : m_db.lastError()).text();
+        m_db.rollback();
+
+        return fail(message);
+    }
+
+    m_applied.insert(version);
+    return true;
+}
+
+bool Migration::isApplied(const QString &version) const
+{
+    return m_applied.contains(version);
+}
+
+QString Migration::errorString() const
+{
+    return m_errorString;
+}
+
+bool Migration::isComplete(const QString &statement)
+{
+    StatementScanner scanner;
+    for (const QChar ch : statement)
+        scanner.scan(ch);
+    scanner.scan(QLatin1Char('\n'));
+
+    return scanner.isComplete();
+}
+
+bool Migration::prepare()
+{
+    if(m_prepared)
+        return true;
+
+    QSqlQuery query(m_db);
+    if(!query.exec("CREATE TABLE IF NOT EXISTS schema_migrations ("
+                   "`version` VARCHAR PRIMARY KEY NOT NULL, "
+                   "`applied_at` DATETIME NOT NULL DEFAULT (datetime('now', 'localtime')))"))
+        return fail("Migration table error " + query.lastError().text());
+
+    if(!query.exec("SELECT version FROM schema_migrations"))
+        return fail("Migration table error " + query.lastError().text());
+
+    while (query.next())
+        m_applied.insert(query.value(0).toString());
+
+    m_prepared = true;
+    return true;
+}
+
+bool Migration::fail(const QString &message)
+{
+    qCritical() << message;
+    m_errorString = message;
+
+    return false;
+}
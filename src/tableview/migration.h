@@ -0,0 +1,62 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename migration.h
+ * @class Migration
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef MIGRATION_H
+#define MIGRATION_H
+
+#include <QSet>
+#include <QString>
+#include <QSqlDatabase>
+
+/**
+ * Applies the `.sql` files of a directory in name order.
+ *
+ * Every file is one migration, its base name (e.g. `001_books`) is the
+ * version recorded in the `schema_migrations` table, versions found there
+ * are skipped. The statements of a file are read one by one and run in a
+ * single transaction, a failing statement rolls the whole file back.
+ */
+class Migration
+{
+public:
+    explicit Migration(const QSqlDatabase &db);
+
+    bool run(const QString &directory = QStringLiteral(":/migrations"));
+    bool apply(const QString &version, const QString &file);
+
+    bool isApplied(const QString &version) const;
+    QString errorString() const;
+
+    static bool isComplete(const QString &statement);
+
+private:
+    bool prepare();
+    bool fail(const QString &message);
+
+    QSqlDatabase m_db;
+    QSet<QString> m_applied;
+    bool m_prepared = false;
+    QString m_errorString;
+};
+
+#endif // MIGRATION_H
@@ -4,5 +4,5 @@ CREATE TABLE IF NOT EXISTS publisher (
 	`address` VARCHAR2 DEFAULT '',
 	`city` VARCHAR2(50),
 	`state` VARCHAR2(50),
-	`zip` VARCHAR2(50),
+	`zip` VARCHAR2(50)
 );
\ No newline at end of file
@@ -0,0 +1,4 @@
+-- rows in view and rows in the trash are read from their own partial
+-- index, a big trash does not slow down the normal reads
+CREATE INDEX IF NOT EXISTS books_alive_idx ON books (id) WHERE deleted_at IS NULL;
+CREATE INDEX IF NOT EXISTS books_trash_idx ON books (id) WHERE deleted_at IS NOT NULL;
@@ -0,0 +1,22 @@
+-- the rows written by any connection or process, read by the live sync
+-- of the models (liveSync: true); op is 'I', 'U' or 'D'. The triggers
+-- that log a table are installed by ChangeFeed::track() while a model
+-- follows it
+CREATE TABLE IF NOT EXISTS _changes (
+    seq INTEGER PRIMARY KEY AUTOINCREMENT,
+    tbl TEXT NOT NULL,
+    row INTEGER NOT NULL,
+    op TEXT NOT NULL
+);
+
+-- the models of all processes that follow a table
+CREATE TABLE IF NOT EXISTS _changes_tracked (
+    tbl TEXT PRIMARY KEY,
+    users INTEGER NOT NULL
+);
+
+-- the log keeps the last 100000 changes, pruned every 1000
+CREATE TRIGGER IF NOT EXISTS _changes_prune AFTER INSERT ON _changes
+WHEN new.seq % 1000 = 0 BEGIN
+    DELETE FROM _changes WHERE seq <= new.seq - 100000;
+END;
@@ -0,0 +1,467 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename pagecache.cpp
+ * @class PageCache
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "pagecache.h"
+
+#include <QSet>
+#include <QSqlField>
+
+#include <cstring>
+
+static inline qint64 packSpan(int offset, int length)
+{
+    return (qint64(offset) << 32) | quint32(length);
+}
+
+static inline int spanOffset(qint64 slot)
+{
+    return int(slot >> 32);
+}
+
+static inline int spanLength(qint64 slot)
+{
+    return int(quint32(slot));
+}
+
+PageCache::PageCache(int pageSize, int capacity)
+    : m_pageSize(qMax(1, pageSize))
+    , m_capacity(qMax(1, capacity))
+{
+
+}
+
+void PageCache::setPageSize(int rows)
+{
+    rows = qMax(1, rows);
+    if(rows == m_pageSize)
+        return;
+
+    // page numbers and anchors depend on the page size
+    m_pageSize = rows;
+    clear();
+}
+
+int PageCache::pageSize() const
+{
+    return m_pageSize;
+}
+
+void PageCache::setCapacity(int pages)
+{
+    m_capacity = qMax(1, pages);
+    evict();
+}
+
+int PageCache::capacity() const
+{
+    return m_capacity;
+}
+
+bool PageCache::contains(int page) const
+{
+    return m_pages.contains(page);
+}
+
+void PageCache::insert(int page, const QVector<QSqlRecord> &rows)
+{
+    Page &p = m_pages[page];
+    p = Page();
+    p.rows = rows.count();
+    p.lastUsed = ++m_clock;
+    if(!rows.isEmpty())
+    {
+        p.layout = rows.first();
+        p.layout.clearValues();
+    }
+
+    const int columns = p.layout.count();
+    if(m_strings.count() < columns)
+        m_strings.resize(columns);
+
+    // column by column, each array is written in one pass
+    p.columns.resize(columns);
+    for (int column = 0; column < columns; ++column)
+    {
+        Column &c = p.columns[column];
+        c.types.resize(p.rows);
+        c.slots.resize(p.rows);
+
+        const bool intern = internable(column, rows);
+        for (int offset = 0; offset < p.rows; ++offset)
+            store(&p, column, offset, rows.at(offset).value(column), intern);
+    }
+
+    p.text.squeeze();
+    p.blobs.squeeze();
+    evict();
+}
+
+void PageCache::remove(int page)
+{
+    m_pages.remove(page);
+}
+
+void PageCache::invalidateFrom(int page)
+{
+    // rows after an insert or remove are shifted, the pages and
+    // anchors behind it are not valid anymore
+    QHash<int, Page>::iterator it = m_pages.begin();
+    while (it != m_pages.end())
+    {
+        if(it.key() >= page)
+            it = m_pages.erase(it);
+        else
+            ++it;
+    }
+
+    QMap<int, QVariantList>::iterator anchor = m_anchors.upperBound(page);
+    while (anchor != m_anchors.end())
+        anchor = m_anchors.erase(anchor);
+}
+
+void PageCache::clear()
+{
+    m_pages.clear();
+    m_anchors.clear();
+    m_strings.clear();
+    m_clock = 0;
+}
+
+bool PageCache::value(int row, int column, QVariant *value)
+{
+    Page *p = touch(pageOf(row));
+    if(!p)
+        return false;
+
+    const int offset = row - firstRow(pageOf(row));
+    if(offset >= p->rows)
+        return false;
+
+    if(column < 0 || column >= p->columns.count())
+        *value = QVariant();
+    else
+        *value = load(*p, column, offset);
+    return true;
+}
+
+bool PageCache::setValue(int row, int column, const QVariant &value)
+{
+    Page *p = touch(pageOf(row));
+    if(!p)
+        return false;
+
+    const int offset = row - firstRow(pageOf(row));
+    if(offset >= p->rows || column < 0 || column >= p->columns.count())
+        return false;
+
+    // the old text stays in the arena until the page is loaded again
+    store(p, column, offset, value, !m_strings.at(column).values.isEmpty());
+    return true;
+}
+
+QSqlRecord PageCache::record(int row)
+{
+    Page *p = touch(pageOf(row));
+    if(!p)
+        return QSqlRecord();
+
+    const int offset = row - firstRow(pageOf(row));
+    if(offset >= p->rows)
+        return QSqlRecord();
+
+    QSqlRecord record = p->layout;
+    for (int column = 0; column < p->columns.count(); ++column)
+        record.setValue(column, load(*p, column, offset));
+
+    return record;
+}
+
+bool PageCache::setRecord(int row, const QSqlRecord &record)
+{
+    Page *p = touch(pageOf(row));
+    if(!p)
+        return false;
+
+    if(p->rows == 0)
+    {
+        p->layout = record;
+        p->layout.clearValues();
+        p->columns.resize(record.count());
+        if(m_strings.count() < record.count())
+            m_strings.resize(record.count());
+    }
+
+    if(record.count() != p->columns.count())
+        return false;
+
+    // a row right behind the last one of a partial page is appended
+    const int offset = row - firstRow(pageOf(row));
+    if(offset == p->rows && offset < m_pageSize)
+    {
+        ++p->rows;
+        for (Column &c : p->columns)
+        {
+            c.types.append(Null);
+            c.slots.append(0);
+        }
+    }
+    else if(offset >= p->rows)
+    {
+        return false;
+    }
+
+    for (int column = 0; column < p->columns.count(); ++column)
+        store(p, column, offset, record.value(column), !m_strings.at(column).values.isEmpty());
+
+    return true;
+}
+
+void PageCache::setAnchor(int page, const QVariantList &key)
+{
+    if(page > 0)
+        m_anchors.insert(page, key);
+}
+
+bool PageCache::anchor(int page, QVariantList *key) const
+{
+    QMap<int, QVariantList>::const_iterator it = m_anchors.constFind(page);
+    if(it == m_anchors.constEnd())
+        return false;
+
+    *key = it.value();
+    return true;
+}
+
+int PageCache::nearestAnchor(int page) const
+{
+    // the first page needs no anchor, it always starts at the beginning
+    QMap<int, QVariantList>::const_iterator it = m_anchors.upperBound(page);
+    if(it == m_anchors.constBegin())
+        return 0;
+
+    return (--it).key();
+}
+
+QList<int> PageCache::pages() const
+{
+    return m_pages.keys();
+}
+
+QVariantList PageCache::column(int page, int column) const
+{
+    // read without touching, the order of eviction stays as it is
+    QVariantList values;
+    QHash<int, Page>::const_iterator it = m_pages.constFind(page);
+    if(it == m_pages.constEnd() || column < 0 || column >= it->columns.count())
+        return values;
+
+    values.reserve(it->rows);
+    for (int offset = 0; offset < it->rows; ++offset)
+        values << load(*it, column, offset);
+
+    return values;
+}
+
+int PageCache::pageCount() const
+{
+    return m_pages.count();
+}
+
+int PageCache::rowsHeld() const
+{
+    int rows = 0;
+    for (QHash<int, Page>::const_iterator it = m_pages.constBegin(); it != m_pages.constEnd(); ++it)
+        rows += it.value().rows;
+
+    return rows;
+}
+
+qint64 PageCache::bytesHeld() const
+{
+    qint64 bytes = 0;
+    for (QHash<int, Page>::const_iterator it = m_pages.constBegin(); it != m_pages.constEnd(); ++it)
+    {
+        const Page &p = it.value();
+        bytes += p.text.capacity() * qint64(sizeof(QChar)) + p.blobs.capacity();
+        for (const Column &c : p.columns)
+            bytes += c.types.capacity() + c.slots.capacity() * qint64(sizeof(qint64))
+                    + c.others.count() * qint64(sizeof(QVariant));
+    }
+
+    for (const Strings &strings : m_strings)
+    {
+        for (const QString &value : strings.values)
+            bytes += value.size() * qint64(sizeof(QChar));
+    }
+
+    return bytes;
+}
+
+PageCache::Page *PageCache::touch(int page)
+{
+    QHash<int, Page>::iterator it = m_pages.find(page);
+    if(it == m_pages.end())
+        return nullptr;
+
+    it.value().lastUsed = ++m_clock;
+    return &it.value();
+}
+
+void PageCache::evict()
+{
+    while (m_pages.count() > m_capacity)
+    {
+        QHash<int, Page>::iterator oldest = m_pages.begin();
+        for (QHash<int, Page>::iterator it = m_pages.begin(); it != m_pages.end(); ++it)
+        {
+            if(it.value().lastUsed < oldest.value().lastUsed)
+                oldest = it;
+        }
+
+        m_pages.erase(oldest);
+    }
+}
+
+void PageCache::store(Page *page, int column, int offset, const QVariant &value, bool intern)
+{
+    Column &c = page->columns[column];
+    if(c.types.at(offset) == Other)
+        c.others.remove(offset);
+
+    quint8 type = Null;
+    qint64 slot = 0;
+    if(!value.isNull())
+    {
+        switch (value.type())
+        {
+        case QVariant::Int:
+            type = Int;
+            slot = value.toInt();
+            break;
+        case QVariant::LongLong:
+            type = LongLong;
+            slot = value.toLongLong();
+            break;
+        case QVariant::Double:
+        {
+            const double real = value.toDouble();
+            type = Double;
+            std::memcpy(&slot, &real, sizeof(slot));
+            break;
+        }
+        case QVariant::String:
+        {
+            const QString text = value.toString();
+            Strings &strings = m_strings[column];
+            const QHash<QString, int>::const_iterator id = strings.ids.constFind(text);
+            if(id != strings.ids.constEnd())
+            {
+                type = Interned;
+                slot = id.value();
+            }
+            else if(intern && text.size() <= MaxInternedLength && strings.values.count() < MaxInterned)
+            {
+                type = Interned;
+                slot = strings.values.count();
+                strings.ids.insert(text, strings.values.count());
+                strings.values.append(text);
+            }
+            else
+            {
+                type = Text;
+                slot = packSpan(page->text.size(), text.size());
+                page->text += text;
+            }
+            break;
+        }
+        case QVariant::ByteArray:
+        {
+            const QByteArray blob = value.toByteArray();
+            type = Blob;
+            slot = packSpan(page->blobs.size(), blob.size());
+            page->blobs += blob;
+            break;
+        }
+        default:
+            type = Other;
+            c.others.insert(offset, value);
+            break;
+        }
+    }
+
+    c.types[offset] = type;
+    c.slots[offset] = slot;
+}
+
+QVariant PageCache::load(const Page &page, int column, int offset) const
+{
+    const Column &c = page.columns.at(column);
+    const qint64 slot = c.slots.at(offset);
+    switch (c.types.at(offset))
+    {
+    case Int:
+        return int(slot);
+    case LongLong:
+        return slot;
+    case Double:
+    {
+        double real;
+        std::memcpy(&real, &slot, sizeof(real));
+        return real;
+    }
+    case Text:
+        return QString(page.text.constData() + spanOffset(slot), spanLength(slot));
+    case Interned:
+        return m_strings.at(column).values.at(int(slot));
+    case Blob:
+        return page.blobs.mid(spanOffset(slot), spanLength(slot));
+    case Other:
+        return c.others.value(offset);
+    default:
+        // a NULL keeps the type of its field
+        return QVariant(page.layout.field(column).type());
+    }
+}
+
+bool PageCache::internable(int column, const QVector<QSqlRecord> &rows) const
+{
+    // a column of few distinct strings, e.g. one value for every fourth row
+    const Strings &strings = m_strings.at(column);
+    if(!strings.values.isEmpty())
+        return true;
+
+    QSet<QString> distinct;
+    int count = 0;
+    for (const QSqlRecord &record : rows)
+    {
+        const QVariant value = record.value(column);
+        if(value.isNull() || value.type() != QVariant::String)
+            continue;
+
+        ++count;
+        distinct.insert(value.toString());
+    }
+
+    return count > 0 && distinct.count() * 4 <= count;
+}
@@ -0,0 +1,139 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename pagecache.h
+ * @class PageCache
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QVariant>
+#include <QSqlRecord>
+
+/**
+ * A bounded cache of fixed size row pages used by the windowed fetch mode.
+ *
+ * Only `capacity` pages are kept in memory, the least recently used page is
+ * evicted first. For every page loaded the key of its last row is remembered
+ * as the anchor of the next page, so the following page can be fetched with
+ * a keyset query (`WHERE key > anchor`) instead of a growing OFFSET.
+ *
+ * A page is held by column: one type byte and one 64 bit slot per cell.
+ * Integers and reals are stored in the slot, text and blobs as offset and
+ * length into an arena of the page. Strings repeated within a column, like
+ * a publisher or an author, are interned once for the whole cache and the
+ * slot holds their id. QVariants are made only when a value is read.
+ */
+class PageCache
+{
+public:
+    explicit PageCache(int pageSize = 256, int capacity = 32);
+
+    void setPageSize(int rows);
+    int pageSize() const;
+
+    void setCapacity(int pages);
+    int capacity() const;
+
+    int pageOf(int row) const { return row / m_pageSize; }
+    int firstRow(int page) const { return page * m_pageSize; }
+
+    bool contains(int page) const;
+    void insert(int page, const QVector<QSqlRecord> &rows);
+    void remove(int page);
+    void invalidateFrom(int page);
+    void clear();
+
+    bool value(int row, int column, QVariant *value);
+    bool setValue(int row, int column, const QVariant &value);
+    QSqlRecord record(int row);
+    bool setRecord(int row, const QSqlRecord &record);
+
+    void setAnchor(int page, const QVariantList &key);
+    bool anchor(int page, QVariantList *key) const;
+    int nearestAnchor(int page) const;
+
+    // the pages held and the values of one column of a page, e.g. to find
+    // the rows of changed keys
+    QList<int> pages() const;
+    QVariantList column(int page, int column) const;
+
+    int pageCount() const;
+    int rowsHeld() const;
+    qint64 bytesHeld() const;
+
+private:
+    enum {
+        MaxInterned = 4096,     // distinct strings per column
+        MaxInternedLength = 64
+    };
+
+    enum CellType : quint8 {
+        Null = 0,
+        Int,
+        LongLong,
+        Double,
+        Text,       // offset and length into the text arena
+        Interned,   // id into the strings of the column
+        Blob,       // offset and length into the blob arena
+        Other       // any other type, kept as QVariant
+    };
+
+    struct Column
+    {
+        QVector<quint8> types;
+        QVector<qint64> slots;
+        QHash<int, QVariant> others;
+    };
+
+    struct Page
+    {
+        int rows = 0;
+        QSqlRecord layout;      // field names and types, no values
+        QVector<Column> columns;
+        QString text;
+        QByteArray blobs;
+        quint64 lastUsed = 0;
+    };
+
+    struct Strings
+    {
+        QVector<QString> values;
+        QHash<QString, int> ids;
+    };
+
+    Page *touch(int page);
+    void evict();
+    void store(Page *page, int column, int offset, const QVariant &value, bool intern);
+    QVariant load(const Page &page, int column, int offset) const;
+    bool internable(int column, const QVector<QSqlRecord> &rows) const;
+
+    int m_pageSize;
+    int m_capacity;
+    quint64 m_clock = 0;
+    QHash<int, Page> m_pages;
+    QMap<int, QVariantList> m_anchors;
+    QVector<Strings> m_strings;
+};
+
+#endif // PAGECACHE_H
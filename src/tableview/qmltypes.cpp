@@ -0,0 +1,43 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename qmltypes.cpp
+ * @class QmlTypes
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "qmltypes.h"
+#include "aggregatemodel.h"
+#include "columngeometry.h"
+#include "gridlines.h"
+#include "tablemetrics.h"
+#include "tablemodel.h"
+
+#include <QQmlEngine>
+
+void QmlTypes::registerTypes()
+{
+    qmlRegisterType<TableModel>("Macai.App", 1, 0, "SqlTableModel");
+    qmlRegisterType<GridLines>("Macai.App", 1, 0, "GridLines");
+    qmlRegisterType<AggregateModel>("Macai.App", 1, 0, "SqlAggregateModel");
+    qmlRegisterUncreatableType<TableMetrics>("Macai.App", 1, 0, "TableMetrics",
+                                             "TableMetrics is read from SqlTableModel.metrics");
+    qmlRegisterUncreatableType<ColumnGeometry>("Macai.App", 1, 0, "ColumnGeometry",
+                                               "ColumnGeometry is read from SqlTableModel.geometry");
+}
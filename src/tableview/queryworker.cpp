@@ -0,0 +1,221 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename queryworker.cpp
+ * @class QueryWorker
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "queryworker.h"
+#include "sql.h"
+#include "tablemetrics.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QWeakPointer>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcQueryWorker, "app.QueryWorker")
+
+// pools in use by database, all users live in the GUI thread
+static QHash<QString, QWeakPointer<QueryPool> > &pools()
+{
+    static QHash<QString, QWeakPointer<QueryPool> > hash;
+    return hash;
+}
+
+QueryWorker::QueryWorker(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QueryResult>();
+}
+
+void QueryWorker::post(const QueryTask &task)
+{
+    // queued into the worker thread, safe to call from any thread
+    QMetaObject::invokeMethod(this, [this, task]() {
+        run(task);
+    }, Qt::QueuedConnection);
+}
+
+void QueryWorker::run(const QueryTask &task)
+{
+    QueryResult result;
+    result.kind = task.kind;
+    result.owner = task.owner;
+    result.origin = task.origin;
+    result.generation = task.generation;
+    result.serial = task.serial;
+    result.page = task.page;
+    result.statement = task.kind == QueryTask::Transaction
+            ? QString::number(task.statements.count()) + " statements" : task.statement;
+    result.started = TableMetrics::now();
+
+    if(task.kind == QueryTask::Transaction)
+    {
+        transaction(task, &result);
+        result.elapsed = TableMetrics::now() - result.started;
+        emit finished(result);
+        return;
+    }
+
+    QSqlQuery query = Sql::prepare(task.statement, Sql::database(task.databaseName));
+    for (const QVariant &value : task.values)
+        query.addBindValue(value);
+
+    result.ok = query.exec();
+    if(!result.ok)
+    {
+        result.errorString = query.lastError().text();
+        qWarning(lcQueryWorker) << task.statement << result.errorString;
+        result.elapsed = TableMetrics::now() - result.started;
+        emit finished(result);
+        return;
+    }
+
+    switch (task.kind)
+    {
+    case QueryTask::Count:
+    case QueryTask::Estimate:
+        result.count = query.next() ? query.value(0).toInt() : 0;
+        break;
+    case QueryTask::Page:
+    case QueryTask::Read:
+        while (query.next())
+            result.rows.append(query.record());
+        break;
+    case QueryTask::Exec:
+    case QueryTask::Transaction:
+        break;
+    }
+
+    query.finish();
+    result.elapsed = TableMetrics::now() - result.started;
+    emit finished(result);
+}
+
+void QueryWorker::transaction(const QueryTask &task, QueryResult *result)
+{
+    QSqlDatabase db = Sql::database(task.databaseName);
+    result->ok = db.transaction();
+    if(!result->ok)
+        result->errorString = db.lastError().text();
+
+    for (int i = 0; result->ok && i < task.statements.count(); ++i)
+    {
+        QSqlQuery query = Sql::prepare(task.statements.at(i), db);
+        for (const QVariant &value : task.batch.value(i))
+            query.addBindValue(value);
+
+        result->ok = query.exec();
+        if(!result->ok)
+        {
+            result->errorString = query.lastError().text();
+            break;
+        }
+
+        result->count += query.numRowsAffected();
+        query.finish();
+    }
+
+    if(result->ok && !db.commit())
+    {
+        result->ok = false;
+        result->errorString = db.lastError().text();
+    }
+
+    if(!result->ok)
+    {
+        qWarning(lcQueryWorker) << "Transaction error" << result->errorString;
+        db.rollback();
+    }
+}
+
+QueryThread::QueryThread()
+    : m_worker(new QueryWorker())
+{
+    m_worker->moveToThread(&m_thread);
+    QObject::connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.setObjectName(QStringLiteral("QueryWorker"));
+    m_thread.start();
+}
+
+QueryThread::~QueryThread()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+QueryWorker *QueryThread::worker() const
+{
+    return m_worker;
+}
+
+QSharedPointer<QueryPool> QueryPool::acquire(const QString &databaseName)
+{
+    QSharedPointer<QueryPool> pool = pools().value(databaseName).toStrongRef();
+    if(pool)
+        return pool;
+
+    // deleted later, a user may let go of it while it emits
+    pool = QSharedPointer<QueryPool>(new QueryPool(databaseName), &QObject::deleteLater);
+    pools().insert(databaseName, pool);
+    return pool;
+}
+
+int QueryPool::nextOwner()
+{
+    static QAtomicInt owners;
+    return owners.fetchAndAddRelaxed(1) + 1;
+}
+
+QueryPool::QueryPool(const QString &databaseName)
+    : m_databaseName(databaseName)
+{
+
+}
+
+QueryPool::~QueryPool()
+{
+    qDeleteAll(m_threads);
+
+    // a pool of the same database may be in use again already
+    QHash<QString, QWeakPointer<QueryPool> >::iterator it = pools().find(m_databaseName);
+    if(it != pools().end() && it->isNull())
+        pools().erase(it);
+}
+
+QString QueryPool::databaseName() const
+{
+    return m_databaseName;
+}
+
+QueryWorker *QueryPool::worker(int index)
+{
+    while (m_threads.count() <= index)
+    {
+        QueryThread *thread = new QueryThread();
+        connect(thread->worker(), &QueryWorker::finished, this, &QueryPool::finished);
+        m_threads.append(thread);
+    }
+
+    return m_threads.at(index)->worker();
+}
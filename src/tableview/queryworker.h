@@ -0,0 +1,146 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename queryworker.h
+ * @class QueryWorker
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef QUERYWORKER_H
+#define QUERYWORKER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QThread>
+#include <QVector>
+#include <QVariant>
+#include <QSqlRecord>
+
+struct QueryTask
+{
+    enum Kind {
+        Count = 0,  // first column of the first row as count
+        Page,       // all rows of the result
+        Exec,       // no result rows
+        Transaction,// all statements in one transaction, count is rows affected
+        Read,       // all rows of the result, for the model that posted it
+        Estimate    // first column of the first row as rows shown until counted
+    };
+
+    Kind kind = Exec;
+    int owner = 0;                  // the source or model the result goes back to
+    int origin = 0;                 // the model that asked, it counts and reports the result
+    int generation = 0;
+    int serial = 0;
+    int page = -1;
+    QString databaseName;
+    QString statement;
+    QVariantList values;
+    QStringList statements;         // Transaction only, with values by index
+    QVector<QVariantList> batch;
+};
+
+struct QueryResult
+{
+    QueryTask::Kind kind = QueryTask::Exec;
+    int owner = 0;
+    int origin = 0;
+    int generation = 0;
+    int serial = 0;
+    int page = -1;
+    bool ok = false;
+    int count = 0;
+    QString errorString;
+    QVector<QSqlRecord> rows;
+    QString statement;      // for traces
+    qint64 started = 0;     // TableMetrics::now()
+    qint64 elapsed = 0;     // ns
+};
+
+Q_DECLARE_METATYPE(QueryResult)
+
+/**
+ * Runs queries on its own thread with the per-thread connection handed
+ * out by Sql::database(), results are delivered back by finished().
+ */
+class QueryWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QueryWorker(QObject *parent = nullptr);
+
+    void post(const QueryTask &task);
+
+signals:
+    void finished(const QueryResult &result);
+
+private:
+    void run(const QueryTask &task);
+    void transaction(const QueryTask &task, QueryResult *result);
+};
+
+/**
+ * Owns a QueryWorker and the thread it lives in.
+ */
+class QueryThread
+{
+public:
+    QueryThread();
+    ~QueryThread();
+
+    QueryWorker *worker() const;
+
+private:
+    QThread m_thread;
+    QueryWorker *m_worker;
+};
+
+/**
+ * The worker threads of one database, shared by all sources and models
+ * that query it.
+ *
+ * Tasks posted to the first worker keep their order, so pages are read
+ * after the writes posted before them; page reads of a read only file may
+ * go round more workers. Every result is handed to all users by
+ * finished(), each takes those posted with its own owner id. The pool
+ * goes away with its last user.
+ */
+class QueryPool : public QObject
+{
+    Q_OBJECT
+public:
+    static QSharedPointer<QueryPool> acquire(const QString &databaseName);
+    static int nextOwner();
+    ~QueryPool() override;
+
+    QString databaseName() const;
+
+    // started on first use
+    QueryWorker *worker(int index);
+
+signals:
+    void finished(const QueryResult &result);
+
+private:
+    explicit QueryPool(const QString &databaseName);
+
+    QString m_databaseName;
+    QVector<QueryThread *> m_threads;
+};
+
+#endif // QUERYWORKER_H
@@ -0,0 +1,195 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename relationcache.cpp
+ * @class RelationCache
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "relationcache.h"
+#include "sql.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariantMap>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcRelationCache, "app.RelationCache")
+
+// serials of the tables written in this process
+static QMutex &serialMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+static QHash<QString, int> &serials()
+{
+    static QHash<QString, int> tables;
+    return tables;
+}
+
+// counts the writes to any table, the serials are compared once it moves
+static QAtomicInt &changes()
+{
+    static QAtomicInt counter;
+    return counter;
+}
+
+void RelationCache::setRelation(int column, const QSqlRelation &relation)
+{
+    if(!relation.isValid())
+    {
+        m_relations.remove(column);
+        return;
+    }
+
+    Relation &r = m_relations[column];
+    r = Relation();
+    r.relation = relation;
+}
+
+QSqlRelation RelationCache::relation(int column) const
+{
+    return m_relations.value(column).relation;
+}
+
+void RelationCache::clear()
+{
+    m_relations.clear();
+}
+
+QVariant RelationCache::display(int column, const QVariant &key, const QSqlDatabase &db)
+{
+    QMap<int, Relation>::iterator it = m_relations.find(column);
+    if(it == m_relations.end() || key.isNull())
+        return key;
+
+    Relation &r = it.value();
+    if(!update(r, db))
+        return key;
+
+    // an unknown key is shown as it is
+    bool isInt = false;
+    const qint64 id = key.toLongLong(&isInt);
+    if(isInt)
+    {
+        QHash<qint64, QString>::const_iterator value = r.values.constFind(id);
+        return value != r.values.constEnd() ? QVariant(value.value()) : key;
+    }
+
+    QHash<QString, QString>::const_iterator value = r.textValues.constFind(key.toString());
+    return value != r.textValues.constEnd() ? QVariant(value.value()) : key;
+}
+
+QVariantList RelationCache::entries(int column, const QSqlDatabase &db)
+{
+    QVariantList list;
+    QMap<int, Relation>::iterator it = m_relations.find(column);
+    if(it == m_relations.end())
+        return list;
+
+    Relation &r = it.value();
+    if(!update(r, db))
+        return list;
+
+    list.reserve(r.order.count());
+    for (const QPair<QVariant, QString> &entry : r.order)
+    {
+        QVariantMap map;
+        map.insert(QStringLiteral("key"), entry.first);
+        map.insert(QStringLiteral("display"), entry.second);
+        list << map;
+    }
+
+    return list;
+}
+
+void RelationCache::invalidate(const QString &table)
+{
+    QMutexLocker locker(&serialMutex());
+    ++serials()[table.toLower()];
+    changes().fetchAndAddRelease(1);
+}
+
+bool RelationCache::update(RelationCache::Relation &r, const QSqlDatabase &db)
+{
+    // read before the serial, a write in between is compared next time
+    const int changed = changes().loadAcquire();
+    if(r.checked == changed)
+        return true;
+
+    if(r.serial != serialOf(r.relation.tableName()) && !load(r, db))
+        return false;
+
+    r.checked = changed;
+    return true;
+}
+
+bool RelationCache::load(RelationCache::Relation &r, const QSqlDatabase &db)
+{
+    const QSqlDriver *driver = db.driver();
+    const QString statement = QString("SELECT %1, %2 FROM %3 ORDER BY %2")
+            .arg(driver->escapeIdentifier(r.relation.indexColumn(), QSqlDriver::FieldName),
+                 driver->escapeIdentifier(r.relation.displayColumn(), QSqlDriver::FieldName),
+                 driver->escapeIdentifier(r.relation.tableName(), QSqlDriver::TableName));
+
+    // taken before reading, a write in between reads again next time
+    const int serial = serialOf(r.relation.tableName());
+
+    QSqlQuery query = Sql::prepare(statement, db);
+    if(!query.exec())
+    {
+        qWarning(lcRelationCache) << statement << query.lastError().text();
+        return false;
+    }
+
+    r.values.clear();
+    r.textValues.clear();
+    r.order.clear();
+    while (query.next())
+    {
+        const QVariant key = query.value(0);
+        const QString display = query.value(1).toString();
+        bool isInt = false;
+        const qint64 id = key.toLongLong(&isInt);
+        if(isInt)
+            r.values.insert(id, display);
+        else
+            r.textValues.insert(key.toString(), display);
+        r.order.append(qMakePair(key, display));
+    }
+    query.finish();
+
+    r.values.squeeze();
+    r.textValues.squeeze();
+    r.serial = serial;
+
+    qDebug(lcRelationCache) << "load relation" << r.relation.tableName() << "values:" << r.order.count();
+    return true;
+}
+
+int RelationCache::serialOf(const QString &table)
+{
+    QMutexLocker locker(&serialMutex());
+    return serials().value(table.toLower(), 0);
+}
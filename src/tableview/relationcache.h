@@ -0,0 +1,77 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename relationcache.h
+ * @class RelationCache
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef RELATIONCACHE_H
+#define RELATIONCACHE_H
+
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QSqlRelation>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * Resolves foreign keys to the display values of small dimension tables.
+ *
+ * A related table is read once into a key to string map when a value of it
+ * is needed first. Writes to a table anywhere in the process are announced
+ * by invalidate(), the maps of that table are read again on the next
+ * lookup. Pages keep the plain keys, no JOIN is needed to show them.
+ * A lookup takes no lock as long as no table was written since the last
+ * one.
+ */
+class RelationCache
+{
+public:
+    void setRelation(int column, const QSqlRelation &relation);
+    QSqlRelation relation(int column) const;
+    bool hasRelation(int column) const { return m_relations.contains(column); }
+    bool isEmpty() const { return m_relations.isEmpty(); }
+    void clear();
+
+    QVariant display(int column, const QVariant &key, const QSqlDatabase &db);
+    QVariantList entries(int column, const QSqlDatabase &db);
+
+    static void invalidate(const QString &table);
+
+private:
+    struct Relation
+    {
+        QSqlRelation relation;
+        int serial = -1;
+        int checked = -1;                   // changes() when the serial was compared
+        QHash<qint64, QString> values;      // integer keys, the usual case
+        QHash<QString, QString> textValues;
+        QVector<QPair<QVariant, QString> > order;
+    };
+
+    bool update(Relation &relation, const QSqlDatabase &db);
+    bool load(Relation &relation, const QSqlDatabase &db);
+    static int serialOf(const QString &table);
+
+    QMap<int, Relation> m_relations;
+};
+
+#endif // RELATIONCACHE_H
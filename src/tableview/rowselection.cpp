@@ -0,0 +1,170 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename rowselection.cpp
+ * @class RowSelection
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "rowselection.h"
+
+#include <algorithm>
+
+static bool endsBefore(const RowRange &range, int row)
+{
+    return range.second < row;
+}
+
+RowSelection::RowSelection()
+{
+
+}
+
+void RowSelection::select(int first, int last)
+{
+    if(first < 0 || first > last)
+        return;
+
+    // merge every range overlapping or adjacent to [first, last]
+    QVector<RowRange>::iterator begin = find(first - 1);
+    QVector<RowRange>::iterator end = begin;
+    while (end != m_ranges.end() && end->first <= last + 1)
+    {
+        first = qMin(first, end->first);
+        last = qMax(last, end->second);
+        m_count -= end->second - end->first + 1;
+        ++end;
+    }
+
+    begin = m_ranges.erase(begin, end);
+    m_ranges.insert(begin, qMakePair(first, last));
+    m_count += last - first + 1;
+}
+
+void RowSelection::deselect(int first, int last)
+{
+    if(first > last)
+        return;
+
+    QVector<RowRange>::iterator it = find(first);
+    while (it != m_ranges.end() && it->first <= last)
+    {
+        const RowRange range = *it;
+        m_count -= range.second - range.first + 1;
+        it = m_ranges.erase(it);
+
+        // keep the parts outside of [first, last]
+        if(range.first < first)
+        {
+            it = m_ranges.insert(it, qMakePair(range.first, first - 1));
+            m_count += first - range.first;
+            ++it;
+        }
+
+        if(range.second > last)
+        {
+            it = m_ranges.insert(it, qMakePair(last + 1, range.second));
+            m_count += range.second - last;
+            ++it;
+        }
+    }
+}
+
+void RowSelection::clear()
+{
+    m_ranges.clear();
+    m_count = 0;
+    m_hint = 0;
+}
+
+bool RowSelection::contains(int row) const
+{
+    if(m_ranges.isEmpty())
+        return false;
+
+    // views ask row by row, the last range hit usually answers again
+    if(m_hint < m_ranges.count())
+    {
+        const RowRange &range = m_ranges.at(m_hint);
+        if(row >= range.first && row <= range.second)
+            return true;
+    }
+
+    QVector<RowRange>::const_iterator it =
+            std::lower_bound(m_ranges.constBegin(), m_ranges.constEnd(), row, endsBefore);
+    if(it == m_ranges.constEnd() || it->first > row)
+        return false;
+
+    m_hint = int(it - m_ranges.constBegin());
+    return true;
+}
+
+void RowSelection::insertRows(int first, int count)
+{
+    if(count <= 0)
+        return;
+
+    for (int i = 0; i < m_ranges.count(); ++i)
+    {
+        RowRange &range = m_ranges[i];
+        if(range.first >= first)
+        {
+            range.first += count;
+            range.second += count;
+        }
+        else if(range.second >= first)
+        {
+            // the new rows split the range, they are not selected
+            const RowRange tail = qMakePair(first + count, range.second + count);
+            range.second = first - 1;
+            m_ranges.insert(i + 1, tail);
+            ++i;
+        }
+    }
+}
+
+void RowSelection::removeRows(int first, int last)
+{
+    if(first > last)
+        return;
+
+    deselect(first, last);
+
+    const int count = last - first + 1;
+    QVector<RowRange>::iterator it = find(first);
+    for (; it != m_ranges.end(); ++it)
+    {
+        it->first -= count;
+        it->second -= count;
+    }
+
+    // the ranges around the removed rows may touch now
+    it = find(first - 1);
+    if(it != m_ranges.end() && it + 1 != m_ranges.end() && it->second + 1 == (it + 1)->first)
+    {
+        it->second = (it + 1)->second;
+        m_ranges.erase(it + 1);
+    }
+}
+
+QVector<RowRange>::iterator RowSelection::find(int row)
+{
+    // first range ending at or after row
+    return std::lower_bound(m_ranges.begin(), m_ranges.end(), row, endsBefore);
+}
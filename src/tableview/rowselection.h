@@ -0,0 +1,66 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename rowselection.h
+ * @class RowSelection
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef ROWSELECTION_H
+#define ROWSELECTION_H
+
+#include <QPair>
+#include <QVector>
+
+// first and last row, both inclusive
+typedef QPair<int, int> RowRange;
+
+/**
+ * Selected rows stored as sorted, disjoint row ranges.
+ *
+ * Selecting all rows or a block of rows is a single range whatever the
+ * row count, the number of selected rows is kept up to date on change.
+ * No QModelIndex is created for a selected row.
+ */
+class RowSelection
+{
+public:
+    RowSelection();
+
+    void select(int first, int last);
+    void deselect(int first, int last);
+    void clear();
+
+    bool contains(int row) const;
+    int count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    const QVector<RowRange> &ranges() const { return m_ranges; }
+
+    // keep the rows in step with the model
+    void insertRows(int first, int count);
+    void removeRows(int first, int last);
+
+private:
+    QVector<RowRange>::iterator find(int row);
+
+    QVector<RowRange> m_ranges;
+    int m_count = 0;
+    mutable int m_hint = 0;
+};
+
+#endif // ROWSELECTION_H
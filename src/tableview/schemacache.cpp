@@ -0,0 +1,222 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename schemacache.cpp
+ * @class SchemaCache
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "schemacache.h"
+
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSqlDriver>
+#include <QSqlQuery>
+
+static QMutex &schemaMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+// the COLLATE of the column definitions of CREATE TABLE, split at the
+// commas outside of parentheses and quotes
+static QHash<QString, QString> declaredCollations(const QString &sql)
+{
+    QHash<QString, QString> collations;
+    const int open = sql.indexOf(QLatin1Char('('));
+    const int close = sql.lastIndexOf(QLatin1Char(')'));
+    if(open < 0 || close <= open)
+        return collations;
+
+    QStringList definitions;
+    QChar quote;
+    int depth = 0;
+    int start = open + 1;
+    for (int i = start; i < close; ++i)
+    {
+        const QChar c = sql.at(i);
+        if(!quote.isNull())
+        {
+            if(c == quote)
+                quote = QChar();
+        }
+        else if(c == QLatin1Char('\'') || c == QLatin1Char('"') || c == QLatin1Char('`'))
+        {
+            quote = c;
+        }
+        else if(c == QLatin1Char('['))
+        {
+            quote = QLatin1Char(']');
+        }
+        else if(c == QLatin1Char('('))
+        {
+            ++depth;
+        }
+        else if(c == QLatin1Char(')'))
+        {
+            --depth;
+        }
+        else if(c == QLatin1Char(',') && depth == 0)
+        {
+            definitions << sql.mid(start, i - start);
+            start = i + 1;
+        }
+    }
+    definitions << sql.mid(start, close - start);
+
+    static const QRegularExpression name("^\\s*(?:\"([^\"]+)\"|`([^`]+)`|\\[([^\\]]+)\\]|(\\w+))");
+    static const QRegularExpression collate("\\bCOLLATE\\s+\"?(\\w+)\"?", QRegularExpression::CaseInsensitiveOption);
+    for (const QString &definition : definitions)
+    {
+        const QRegularExpressionMatch field = name.match(definition);
+        const QRegularExpressionMatch collation = collate.match(definition);
+        if(!field.hasMatch() || !collation.hasMatch())
+            continue;
+
+        QString fieldName;
+        for (int i = 1; fieldName.isEmpty() && i <= 4; ++i)
+            fieldName = field.captured(i);
+        collations.insert(fieldName.toLower(), collation.captured(1).toUpper());
+    }
+    return collations;
+}
+
+bool SchemaCache::validate(const QSqlDatabase &db)
+{
+    QMutexLocker locker(&schemaMutex());
+    Schema &s = schema(db);
+    if(!s.loaded)
+        return false;
+
+    // one read of the database header, no parse of sqlite_master
+    if(version(db) == s.version)
+        return true;
+
+    s = Schema();
+    return false;
+}
+
+void SchemaCache::invalidate(const QSqlDatabase &db)
+{
+    QMutexLocker locker(&schemaMutex());
+    schema(db) = Schema();
+}
+
+QStringList SchemaCache::tables(const QSqlDatabase &db)
+{
+    QMutexLocker locker(&schemaMutex());
+    Schema &s = schema(db);
+    load(db, &s);
+    return s.tables;
+}
+
+bool SchemaCache::hasTable(const QSqlDatabase &db, const QString &name)
+{
+    return tables(db).contains(name, Qt::CaseInsensitive);
+}
+
+bool SchemaCache::analyzed(const QSqlDatabase &db)
+{
+    QMutexLocker locker(&schemaMutex());
+    Schema &s = schema(db);
+    load(db, &s);
+    return s.analyzed;
+}
+
+SchemaCache::Table SchemaCache::table(const QSqlDatabase &db, const QString &name)
+{
+    QMutexLocker locker(&schemaMutex());
+    Schema &s = schema(db);
+    load(db, &s);
+
+    const QString id = name.toLower();
+    QHash<QString, Table>::const_iterator it = s.info.constFind(id);
+    if(it != s.info.constEnd())
+        return it.value();
+
+    Table t;
+    if(s.tables.contains(name, Qt::CaseInsensitive))
+    {
+        t.record = db.record(name);
+        t.primaryKey = db.primaryIndex(name);
+
+        const QString table = db.driver()->escapeIdentifier(name, QSqlDriver::TableName);
+        QSqlQuery query(db);
+        if(query.exec("PRAGMA table_info(" + table + ")"))
+        {
+            while (query.next())
+                t.types.insert(query.value(1).toString(), query.value(2).toString().toUpper());
+        }
+        if(query.exec("PRAGMA index_list(" + table + ")"))
+        {
+            while (query.next())
+                t.indexes << query.value(1).toString();
+        }
+        query.prepare("SELECT sql FROM sqlite_master WHERE type = 'table' AND name = ? COLLATE NOCASE");
+        query.addBindValue(name);
+        if(query.exec() && query.next())
+            t.collations = declaredCollations(query.value(0).toString());
+    }
+
+    s.info.insert(id, t);
+    return t;
+}
+
+SchemaCache::Schema &SchemaCache::schema(const QSqlDatabase &db)
+{
+    // by file, the connections of all threads to it see the same schema
+    static QHash<QString, Schema> schemas;
+    return schemas[db.databaseName()];
+}
+
+void SchemaCache::load(const QSqlDatabase &db, Schema *schema)
+{
+    if(schema->loaded || !db.isOpen())
+        return;
+
+    // the version first, DDL in between is seen by the next validate()
+    schema->version = version(db);
+    schema->info.clear();
+    schema->tables.clear();
+
+    QSqlQuery query(db);
+    // the tables of SQLite itself are left out, sqlite_stat1 tells ANALYZE ran
+    if(query.exec(QStringLiteral("SELECT name FROM sqlite_master WHERE type IN ('table', 'view')")))
+    {
+        while (query.next())
+        {
+            const QString name = query.value(0).toString();
+            if(!name.startsWith(QLatin1String("sqlite_"), Qt::CaseInsensitive))
+                schema->tables << name;
+            else if(name.compare(QLatin1String("sqlite_stat1"), Qt::CaseInsensitive) == 0)
+                schema->analyzed = true;
+        }
+    }
+    schema->loaded = true;
+}
+
+int SchemaCache::version(const QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if(!query.exec(QStringLiteral("PRAGMA schema_version")) || !query.next())
+        return -1;
+
+    return query.value(0).toInt();
+}
@@ -0,0 +1,79 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename schemacache.h
+ * @class SchemaCache
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef SCHEMACACHE_H
+#define SCHEMACACHE_H
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlIndex>
+#include <QSqlRecord>
+#include <QStringList>
+
+/**
+ * The schema of a database, read once and shared by all connections to it.
+ *
+ * The names of the tables and views are read from sqlite_master on first
+ * use, the fields, declared types and collations, primary key and indexes
+ * of a table when it is asked for first. DDL run by this process
+ * (migrations, automatic indexes) calls invalidate(). validate() compares
+ * `PRAGMA schema_version` with the version read, which catches DDL of
+ * other connections and processes without reading sqlite_master again.
+ */
+class SchemaCache
+{
+public:
+    struct Table
+    {
+        QSqlRecord record;
+        QSqlIndex primaryKey;
+        QHash<QString, QString> types;      // declared type by field, upper case
+        QHash<QString, QString> collations; // declared COLLATE by lower case field, upper case
+        QStringList indexes;
+    };
+
+    static bool validate(const QSqlDatabase &db);
+    static void invalidate(const QSqlDatabase &db);
+
+    static QStringList tables(const QSqlDatabase &db);
+    static bool hasTable(const QSqlDatabase &db, const QString &name);
+    // sqlite_stat1 exists, i.e. ANALYZE ran
+    static bool analyzed(const QSqlDatabase &db);
+    static Table table(const QSqlDatabase &db, const QString &name);
+
+private:
+    struct Schema
+    {
+        bool loaded = false;
+        int version = -1;
+        bool analyzed = false;
+        QStringList tables;
+        QHash<QString, Table> info;     // by lower case name
+    };
+
+    static Schema &schema(const QSqlDatabase &db);
+    static void load(const QSqlDatabase &db, Schema *schema);
+    static int version(const QSqlDatabase &db);
+};
+
+#endif // SCHEMACACHE_H
@@ -24,46 +24,382 @@
 #ifndef SQL_H
 #define SQL_H
 
+#include "migration.h"
+
 #include <QStringList>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QAtomicInt>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSettings>
 #include <QThreadStorage>
+#include <QUrl>
+#include <QUrlQuery>
 #include <QUuid>
 #include <QDebug>
 
 const QString DRIVER = "QSQLITE";
-static QThreadStorage<QSqlDatabase> databasePool;
+// a named in-memory database, shared by the connections of all threads
+const QString MEMORY_DATABASE = "file:tableview?mode=memory&cache=shared";
+
+/**
+ * SQLite settings applied to every pooled connection when it opens.
+ * Empty or negative values leave the SQLite default.
+ */
+struct SqlProfile
+{
+    QString journalMode = "WAL";
+    QString synchronous = "NORMAL";
+    int cacheSize = -16000;             // negative is KiB, positive is pages
+    qint64 mmapSize = 256 * 1024 * 1024;
+    QString tempStore = "MEMORY";
+    int busyTimeout = 5000;             // milliseconds
+
+    // read only connections: pages are read from the mapping, not copied
+    // into the page cache; clamped to SQLITE_MAX_MMAP_SIZE of the build
+    qint64 readOnlyMmapSize = Q_INT64_C(64) * 1024 * 1024 * 1024;
+    int readOnlyCacheSize = -2000;
+};
 
 class Sql
 {
 public:
     static QSqlDatabase memoryDatabase()
     {
-        QSqlDatabase db = Sql::database(":memory:");
-        migrate(db, ":/migrations/001_books.sql");
-
-        return db;
+        // migrated when the connection opens it
+        return Sql::database(":memory:");
     }
 
+    /**
+     * Returns the connection of the calling thread to databaseName, each
+     * database gets a connection of its own the first time it is asked for
+     * and keeps it. An empty name is the memory database. The memory
+     * database, and a file enabled by enableMigrations(), is migrated the
+     * first time it is opened in this process.
+     */
     static QSqlDatabase database(const QString &databaseName = QString(), bool open = true)
     {
-        QSqlDatabase db;
+        const QString name = resolveName(databaseName);
 
-        if(!databasePool.hasLocalData())
+        QHash<QString, SqlConnection> &connections = databasePool().localData();
+        QHash<QString, SqlConnection>::iterator it = connections.find(name);
+        if(it == connections.end())
         {
             QString connName = QUuid::createUuid().toString(QUuid::Id128);
-            db = QSqlDatabase::addDatabase(DRIVER, connName);
-            db.setDatabaseName(databaseName);
-            if(open)
-                db = QSqlDatabase::database(connName, open);
-            databasePool.setLocalData(db);
+            SqlConnection conn;
+            conn.db = QSqlDatabase::addDatabase(DRIVER, connName);
+            setName(conn.db, name);
+            it = connections.insert(name, conn);
+        }
+        SqlConnection &conn = it.value();
+
+        if(open && !conn.db.isOpen() && conn.db.open())
+            migrate(conn.db);
+
+        // a connection picks up a changed profile on next use
+        if(conn.db.isOpen() && conn.profileSerial != profileSerial())
+        {
+            applyProfile(conn.db, profile());
+            conn.profileSerial = profileSerial();
         }
-        db = databasePool.localData();
+
+        return conn.db;
+    }
+
+    /**
+     * Opens a connection of its own to databaseName, for a reader that must
+     * not share the pooled connections of its thread.
+     * Removed by QSqlDatabase::removeDatabase() with its connection name.
+     */
+    static QSqlDatabase addConnection(const QString &databaseName)
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(DRIVER, QUuid::createUuid().toString(QUuid::Id128));
+        reopen(db, databaseName);
+
         return db;
     }
 
+    /**
+     * Returns a closed connection of the calling thread for an owner that
+     * keeps it for its lifetime and moves it by reopen(), one given back
+     * by releaseConnection() is handed out again.
+     */
+    static QSqlDatabase takeConnection()
+    {
+        QStringList &spare = sparePool().localData();
+        if(!spare.isEmpty())
+            return QSqlDatabase::database(spare.takeLast(), false);
+
+        return QSqlDatabase::addDatabase(DRIVER, QUuid::createUuid().toString(QUuid::Id128));
+    }
+
+    /**
+     * Closes db and keeps it for the next takeConnection() of the thread,
+     * its handles may still be held, e.g. by a QSqlTableModel being
+     * destroyed.
+     */
+    static void releaseConnection(QSqlDatabase db)
+    {
+        if(!db.isValid())
+            return;
+
+        db.close();
+        sparePool().localData() << db.connectionName();
+    }
+
+    /**
+     * Opens db again on databaseName, migrated and with the profile;
+     * queries of db are invalid afterwards.
+     */
+    static bool reopen(QSqlDatabase &db, const QString &databaseName)
+    {
+        db.close();
+        setName(db, resolveName(databaseName));
+        if(!db.open())
+            return false;
+
+        migrate(db);
+        applyProfile(db, profile());
+        return true;
+    }
+
+    /**
+     * Returns the read only, immutable connection of the calling thread to
+     * fileName. The connection of the file itself stays writable.
+     */
+    static QSqlDatabase readOnlyDatabase(const QString &fileName)
+    {
+        return database(readOnlyName(fileName));
+    }
+
+    /**
+     * Returns the URI of fileName opened read only and immutable: SQLite
+     * takes no locks and looks for no journal or WAL, the file must not
+     * change while it is open. The memory database is returned as is.
+     */
+    static QString readOnlyName(const QString &fileName)
+    {
+        const QString name = resolveName(fileName);
+        if(name == MEMORY_DATABASE || isReadOnlyName(name))
+            return name;
+
+        QUrl url = name.startsWith("file:") ? QUrl(name)
+                                            : QUrl::fromLocalFile(QFileInfo(name).absoluteFilePath());
+        QUrlQuery query(url);
+        query.removeQueryItem("mode");
+        query.addQueryItem("mode", "ro");
+        query.addQueryItem("immutable", "1");
+        url.setQuery(query);
+        return url.toString(QUrl::FullyEncoded);
+    }
+
+    /**
+     * Returns the name a connection opens for databaseName, empty and
+     * ":memory:" are the shared memory database.
+     */
+    static QString resolveName(const QString &databaseName)
+    {
+        // a plain ":memory:" database is private to its connection,
+        // which would hide the data from the worker threads
+        if(databaseName.isEmpty() || databaseName == ":memory:")
+            return MEMORY_DATABASE;
+
+        return databaseName;
+    }
+
+    static bool isReadOnly(const QSqlDatabase &db)
+    {
+        return isReadOnlyName(db.databaseName());
+    }
+
+    /**
+     * Returns a prepared, forward only query for statement. Queries of the
+     * pooled connections of the calling thread are cached by their normalized
+     * text, bind new values and exec() again instead of preparing again.
+     * A cached query still active, not finished by the caller of its last
+     * use, is not handed out twice; a new one takes its place.
+     */
+    static QSqlQuery prepare(const QString &statement, const QSqlDatabase &db)
+    {
+        SqlConnection *conn = nullptr;
+        if(databasePool().hasLocalData())
+        {
+            QHash<QString, SqlConnection>::iterator it = databasePool().localData().find(db.databaseName());
+            if(it != databasePool().localData().end())
+                conn = &it.value();
+        }
+        if(!conn || conn->db.connectionName() != db.connectionName())
+        {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            query.prepare(statement);
+            return query;
+        }
+
+        const int serial = statementSerial().loadAcquire();
+        if(conn->statementSerial != serial)
+        {
+            conn->statements.clear();
+            conn->used.clear();
+            conn->statementSerial = serial;
+        }
+
+        const QString key = statement.simplified();
+        QHash<QString, QSqlQuery>::iterator it = conn->statements.find(key);
+        if(it != conn->statements.end())
+        {
+            // the most recently used statement is kept at the end
+            conn->used.removeOne(key);
+            conn->used.append(key);
+            if(!it.value().isActive())
+                return it.value();
+        }
+
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if(!query.prepare(statement))
+            return query;
+
+        if(it != conn->statements.end())
+        {
+            it.value() = query;
+            return query;
+        }
+
+        // the least recently used statement makes room
+        if(conn->statements.count() >= MaxStatements)
+            conn->statements.remove(conn->used.takeFirst());
+        conn->statements.insert(key, query);
+        conn->used.append(key);
+
+        return query;
+    }
+
+    /**
+     * Drops the cached statements of all threads, called on schema changes.
+     */
+    static void invalidateStatements()
+    {
+        statementSerial().ref();
+    }
+
+    static SqlProfile profile()
+    {
+        QMutexLocker locker(&profileMutex());
+        return profileStorage();
+    }
+
+    static void setProfile(const SqlProfile &profile)
+    {
+        QMutexLocker locker(&profileMutex());
+        profileStorage() = profile;
+        ++profileSerialStorage();
+    }
+
+    /**
+     * Reads the [sqlite] group of an ini file, keys are named as the pragmas:
+     * journal_mode, synchronous, cache_size, mmap_size, temp_store, busy_timeout
+     * and readonly_mmap_size, readonly_cache_size for read only connections
+     */
+    static bool loadProfile(const QString &fileName)
+    {
+        if(!QFile::exists(fileName))
+            return false;
+
+        QSettings settings(fileName, QSettings::IniFormat);
+        settings.beginGroup("sqlite");
+
+        SqlProfile p = profile();
+        p.journalMode = settings.value("journal_mode", p.journalMode).toString();
+        p.synchronous = settings.value("synchronous", p.synchronous).toString();
+        p.cacheSize = settings.value("cache_size", p.cacheSize).toInt();
+        p.mmapSize = settings.value("mmap_size", p.mmapSize).toLongLong();
+        p.tempStore = settings.value("temp_store", p.tempStore).toString();
+        p.busyTimeout = settings.value("busy_timeout", p.busyTimeout).toInt();
+        p.readOnlyMmapSize = settings.value("readonly_mmap_size", p.readOnlyMmapSize).toLongLong();
+        p.readOnlyCacheSize = settings.value("readonly_cache_size", p.readOnlyCacheSize).toInt();
+        setProfile(p);
+
+        return true;
+    }
+
+    static void applyProfile(const QSqlDatabase &db, const SqlProfile &profile)
+    {
+        // pragma values can not be bound, only known keywords are passed
+        static const QStringList journalModes = { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF" };
+        static const QStringList synchronousModes = { "OFF", "NORMAL", "FULL", "EXTRA" };
+        static const QStringList tempStores = { "DEFAULT", "FILE", "MEMORY" };
+
+        // nothing is written through a read only connection
+        const bool readOnly = isReadOnly(db);
+        const int cacheSize = readOnly ? profile.readOnlyCacheSize : profile.cacheSize;
+        const qint64 mmapSize = readOnly ? profile.readOnlyMmapSize : profile.mmapSize;
+
+        QStringList pragmas;
+        if(!readOnly && journalModes.contains(profile.journalMode, Qt::CaseInsensitive))
+            pragmas << "PRAGMA journal_mode = " + profile.journalMode;
+        if(!readOnly && synchronousModes.contains(profile.synchronous, Qt::CaseInsensitive))
+            pragmas << "PRAGMA synchronous = " + profile.synchronous;
+        if(cacheSize != 0)
+            pragmas << QString("PRAGMA cache_size = %1").arg(cacheSize);
+        if(mmapSize >= 0)
+            pragmas << QString("PRAGMA mmap_size = %1").arg(mmapSize);
+        if(tempStores.contains(profile.tempStore, Qt::CaseInsensitive))
+            pragmas << "PRAGMA temp_store = " + profile.tempStore;
+        if(profile.busyTimeout >= 0)
+            pragmas << QString("PRAGMA busy_timeout = %1").arg(profile.busyTimeout);
+
+        QSqlQuery query(db);
+        foreach(const QString &pragma, pragmas)
+        {
+            if(!query.exec(pragma))
+                qWarning() << pragma << query.lastError().text();
+        }
+    }
+
+    /**
+     * Lets migrate() apply :/migrations to databaseName. Files are left
+     * alone unless enabled, the memory database is always migrated.
+     */
+    static void enableMigrations(const QString &databaseName)
+    {
+        QMutexLocker locker(&migrationMutex());
+        migratingStorage().insert(resolveName(databaseName));
+    }
+
+    /**
+     * Runs the migrations of :/migrations on db once per database name and
+     * process, if it is the memory database or enabled. The memory database
+     * also gets the demo rows of :/seeds and is checked on every open, it is
+     * gone when its last connection closes. Connections of other threads
+     * wait until the first one has migrated the file.
+     */
+    static bool migrate(const QSqlDatabase &db)
+    {
+        if(!db.isOpen() || isReadOnly(db))
+            return false;
+
+        QMutexLocker locker(&migrationMutex());
+        const QString name = db.databaseName();
+        const bool memory = name == MEMORY_DATABASE;
+        if(migratedStorage().contains(name) || (!memory && !migratingStorage().contains(name)))
+            return true;
+
+        Migration migration(db);
+        const bool ok = migration.run(":/migrations") && (!memory || migration.run(":/seeds"));
+        if(!ok)
+            qWarning() << "Migration of" << name << "failed" << migration.errorString();
+        else if(!memory)
+            migratedStorage().insert(name);
+
+        return ok;
+    }
+
     static QSqlDatabase connection(const QString &connectionName)
     {
         if(connectionName.isEmpty())
@@ -73,43 +409,96 @@ public:
     }
 
 private:
-    // TODO: create Migration class
-    static QStringList resolveStatements(const QString &file)
+    enum { MaxStatements = 64 };
+
+    struct SqlConnection
     {
-        QStringList statements;
-        QFile sqlFile(file);
-        if(!sqlFile.open(QIODevice::ReadOnly))
-        {
-            qCritical() << "Can not open file '" << file << "' " << sqlFile.errorString();
-            return statements;
-        }
+        QSqlDatabase db;
+        int profileSerial = -1;
+        // destroyed before the connection they belong to
+        QHash<QString, QSqlQuery> statements;
+        QStringList used;                   // keys, least recently used first
+        int statementSerial = 0;
+    };
 
-        const QString sql = sqlFile.readAll();//.replace("\n", "");
-        statements = sql.split(QRegExp(";"), QString::SkipEmptyParts);
-        if(statements.last() == "\n")
-            statements.removeLast();
+    // the connections of a thread by database name
+    static QThreadStorage<QHash<QString, SqlConnection> > &databasePool()
+    {
+        static QThreadStorage<QHash<QString, SqlConnection> > pool;
+        return pool;
+    }
 
-        sqlFile.close();
+    // connection names given back by releaseConnection()
+    static QThreadStorage<QStringList> &sparePool()
+    {
+        static QThreadStorage<QStringList> pool;
+        return pool;
+    }
 
-        return statements;
+    static QAtomicInt &statementSerial()
+    {
+        static QAtomicInt serial(0);
+        return serial;
     }
 
-    static bool migrate(const QSqlDatabase &db, const QString &file)
+    static QMutex &migrationMutex()
     {
-        const QStringList statements = resolveStatements(file);
-        foreach(const QString &cmd, statements)
-        {
-            db.exec(cmd);
-            if(db.lastError().type() != QSqlError::NoError)
-            {
-                qCritical() << "Migration up error '" << file << "' " << db.lastError().text();
-                qCritical() << cmd;
-
-                return false;
-            }
-        }
+        static QMutex mutex;
+        return mutex;
+    }
 
-        return true;
+    static QSet<QString> &migratedStorage()
+    {
+        static QSet<QString> names;
+        return names;
+    }
+
+    static QSet<QString> &migratingStorage()
+    {
+        static QSet<QString> names;
+        return names;
+    }
+
+    static QMutex &profileMutex()
+    {
+        static QMutex mutex;
+        return mutex;
+    }
+
+    static SqlProfile &profileStorage()
+    {
+        static SqlProfile profile;
+        return profile;
+    }
+
+    static int &profileSerialStorage()
+    {
+        static int serial = 0;
+        return serial;
+    }
+
+    static int profileSerial()
+    {
+        QMutexLocker locker(&profileMutex());
+        return profileSerialStorage();
+    }
+
+    static bool isReadOnlyName(const QString &name)
+    {
+        return name.startsWith("file:")
+                && QUrlQuery(QUrl(name)).queryItemValue("mode") == QLatin1String("ro");
+    }
+
+    static void setName(QSqlDatabase &db, const QString &name)
+    {
+        QStringList options;
+        if(name.startsWith("file:"))
+            options << "QSQLITE_OPEN_URI";
+        if(isReadOnlyName(name))
+            options << "QSQLITE_OPEN_READONLY";
+
+        db.setDatabaseName(name);
+        db.setConnectOptions(options.join(';'));
     }
 };
 
@@ -0,0 +1,301 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename tablemetrics.cpp
+ * @class TableMetrics
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+
+#include "tablemetrics.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QMutex>
+#include <QQuickWindow>
+#include <QtAlgorithms>
+#include <QtMath>
+
+// off unless enabled by QT_LOGGING_RULES="app.Trace.debug=true"
+Q_LOGGING_CATEGORY(lcTrace, "app.Trace", QtInfoMsg)
+
+// a window idle for longer swaps no frames, the gap is no frame time
+static const qint64 MaxFrameTime = 1000000000;
+
+// updated() is emitted at most every NotifyInterval ns
+static const qint64 NotifyInterval = 250000000;
+
+static const QElapsedTimer &traceClock()
+{
+    static const QElapsedTimer timer = []() {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+static QMutex &traceMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+static QFile *&traceFile()
+{
+    static QFile *file = nullptr;
+    return file;
+}
+
+static bool &traceStarted()
+{
+    static bool started = false;
+    return started;
+}
+
+static void closeTrace()
+{
+    QMutexLocker locker(&traceMutex());
+    if(QFile *file = traceFile())
+    {
+        file->write("\n]\n");
+        file->close();
+        delete file;
+        traceFile() = nullptr;
+    }
+}
+
+void TableMetrics::Histogram::add(qint64 value)
+{
+    const int bucket = value <= 0 ? 0 : 64 - qCountLeadingZeroBits(quint64(value));
+    ++counts[qMin(int(Buckets) - 1, bucket)];
+    ++count;
+    total += value;
+    max = qMax(max, value);
+}
+
+qint64 TableMetrics::Histogram::percentile(qreal p) const
+{
+    const qint64 rank = qCeil(p * count);
+    qint64 seen = 0;
+    for (int bucket = 0; bucket < Buckets; ++bucket)
+    {
+        seen += counts[bucket];
+        if(seen >= rank && seen > 0)
+            return bucket == 0 ? 0 : qMin(max, (qint64(1) << bucket) - 1);
+    }
+
+    return max;
+}
+
+QVariantMap TableMetrics::Histogram::toMap(qreal scale) const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), count);
+    map.insert(QStringLiteral("total"), total * scale);
+    map.insert(QStringLiteral("mean"), count > 0 ? total * scale / count : 0.0);
+    map.insert(QStringLiteral("p50"), percentile(0.50) * scale);
+    map.insert(QStringLiteral("p95"), percentile(0.95) * scale);
+    map.insert(QStringLiteral("p99"), percentile(0.99) * scale);
+    map.insert(QStringLiteral("max"), max * scale);
+    return map;
+}
+
+TableMetrics::TableMetrics(QObject *parent)
+    : QObject(parent)
+{
+
+}
+
+qint64 TableMetrics::now()
+{
+    return traceClock().nsecsElapsed();
+}
+
+void TableMetrics::setWindow(QQuickWindow *window)
+{
+    if(m_window == window)
+        return;
+
+    if(m_window)
+        disconnect(m_window, &QQuickWindow::frameSwapped, this, &TableMetrics::onFrameSwapped);
+
+    // emitted by the render thread, queued to the thread of the model
+    m_window = window;
+    m_lastFrame = 0;
+    if(m_window)
+        connect(m_window, &QQuickWindow::frameSwapped, this, &TableMetrics::onFrameSwapped);
+
+    emit windowChanged();
+}
+
+QQuickWindow *TableMetrics::window() const
+{
+    return m_window;
+}
+
+void TableMetrics::addQuery(TableMetrics::QueryType type, qint64 started, qint64 elapsed,
+                            int rows, const QString &statement, bool worker)
+{
+    m_queries[type].add(elapsed / 1000);
+    m_rowsFetched += qMax(0, rows);
+
+    if(lcTrace().isDebugEnabled())
+    {
+        QVariantMap args;
+        args.insert(QStringLiteral("statement"), statement);
+        args.insert(QStringLiteral("rows"), rows);
+        trace(QMetaEnum::fromType<QueryType>().valueToKey(type), started, elapsed, worker ? 2 : 1, args);
+    }
+
+    notify();
+}
+
+void TableMetrics::setBytesHeld(qint64 bytes)
+{
+    m_bytesHeld = bytes;
+}
+
+qint64 TableMetrics::queries() const
+{
+    qint64 count = 0;
+    for (const Histogram &histogram : m_queries)
+        count += histogram.count;
+
+    return count;
+}
+
+qreal TableMetrics::frameTime() const
+{
+    return m_frames.percentile(0.95) / 1000.0;
+}
+
+QVariantMap TableMetrics::snapshot() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("dataCalls"), m_dataCalls);
+    map.insert(QStringLiteral("cacheHits"), m_cacheHits);
+    map.insert(QStringLiteral("cacheMisses"), m_cacheMisses);
+    const qint64 lookups = m_cacheHits + m_cacheMisses;
+    map.insert(QStringLiteral("cacheHitRate"), lookups > 0 ? qreal(m_cacheHits) / lookups : 1.0);
+    map.insert(QStringLiteral("rowsFetched"), m_rowsFetched);
+    map.insert(QStringLiteral("bytesHeld"), m_bytesHeld);
+
+    // durations in ms
+    QVariantMap queries;
+    const QMetaEnum types = QMetaEnum::fromType<QueryType>();
+    for (int type = 0; type < QueryTypes; ++type)
+        queries.insert(QString::fromLatin1(types.valueToKey(type)), m_queries[type].toMap(0.001));
+    map.insert(QStringLiteral("queries"), queries);
+    map.insert(QStringLiteral("frames"), m_frames.toMap(0.001));
+    map.insert(QStringLiteral("dataCallsPerFrame"), m_framesDataCalls.toMap(1.0));
+    return map;
+}
+
+void TableMetrics::reset()
+{
+    m_dataCalls = m_frameDataCalls = 0;
+    m_cacheHits = m_cacheMisses = 0;
+    m_rowsFetched = 0;
+    m_lastFrame = 0;
+    for (Histogram &histogram : m_queries)
+        histogram = Histogram();
+    m_frames = Histogram();
+    m_framesDataCalls = Histogram();
+
+    emit updated();
+}
+
+void TableMetrics::onFrameSwapped()
+{
+    const qint64 time = now();
+    const qint64 elapsed = time - m_lastFrame;
+    if(m_lastFrame > 0 && elapsed < MaxFrameTime)
+    {
+        m_frames.add(elapsed / 1000);
+        m_framesDataCalls.add(m_frameDataCalls);
+
+        if(lcTrace().isDebugEnabled())
+        {
+            QVariantMap args;
+            args.insert(QStringLiteral("dataCalls"), m_frameDataCalls);
+            trace("Frame", m_lastFrame, elapsed, 1, args);
+        }
+    }
+
+    m_lastFrame = time;
+    m_frameDataCalls = 0;
+    notify();
+}
+
+void TableMetrics::notify()
+{
+    // bindings on the metrics are not evaluated inside data()
+    const qint64 time = now();
+    if(time - m_lastNotify < NotifyInterval)
+        return;
+
+    m_lastNotify = time;
+    QMetaObject::invokeMethod(this, &TableMetrics::updated, Qt::QueuedConnection);
+}
+
+void TableMetrics::trace(const char *name, qint64 started, qint64 elapsed, int thread, const QVariantMap &args)
+{
+    QJsonObject event;
+    event.insert(QStringLiteral("name"), QString::fromLatin1(name));
+    event.insert(QStringLiteral("cat"), thread == 2 ? QStringLiteral("worker") : QStringLiteral("gui"));
+    event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+    event.insert(QStringLiteral("ts"), started / 1000.0);
+    event.insert(QStringLiteral("dur"), elapsed / 1000.0);
+    event.insert(QStringLiteral("pid"), QCoreApplication::applicationPid());
+    event.insert(QStringLiteral("tid"), thread);
+    event.insert(QStringLiteral("args"), QJsonObject::fromVariantMap(args));
+
+    QMutexLocker locker(&traceMutex());
+    QFile *&file = traceFile();
+    if(!file && traceStarted())
+        return;
+
+    if(!file)
+    {
+        // opened once, the closing bracket is written at exit
+        traceStarted() = true;
+        file = new QFile(qEnvironmentVariable("TABLEVIEW_TRACE_FILE", QStringLiteral("tableview-trace.json")));
+        if(!file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            qWarning(lcTrace) << "Can not open trace file" << file->fileName() << file->errorString();
+            delete file;
+            file = nullptr;
+            return;
+        }
+
+        file->write("[\n");
+        qAddPostRoutine(closeTrace);
+        qDebug(lcTrace) << "trace to" << file->fileName();
+    }
+    else
+    {
+        file->write(",\n");
+    }
+
+    file->write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,144 @@
+/**
+ * QML examples - Qt5 and QML examples
+ * Copyright (c) 2019 Yuri Young<yuri.young@qq.com>
+ *
+ * This examples is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This examples is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @date 2019/11/28-11-28
+ * @filename tablemetrics.h
+ * @class TableMetrics
+ * @author Yuri Young<yuri.young@qq.com>
+ * @qq 12319597
+ */
+#ifndef TABLEMETRICS_H
+#define TABLEMETRICS_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVariantMap>
+#include <QLoggingCategory>
+
+class QQuickWindow;
+
+Q_DECLARE_LOGGING_CATEGORY(lcTrace)
+
+/**
+ * Counters and latency histograms of a TableModel, read in QML by
+ * `tableModel.metrics` or in C++ by TableModel::metrics().
+ *
+ * Counted are data() calls, page cache hits and misses, the SQL queries by
+ * type with their duration and rows, and the bytes held by the page cache.
+ * With a window set, frames are sampled on QQuickWindow::frameSwapped and
+ * the data() calls of every frame go into a histogram as well.
+ *
+ * With QT_LOGGING_RULES="app.Trace.debug=true" every query and frame is
+ * also written as a Chrome trace event to TABLEVIEW_TRACE_FILE (default
+ * tableview-trace.json), to be opened in chrome://tracing or Perfetto.
+ *
+ * All methods are called in the thread of the model, the worker thread
+ * hands its timings back with the query results.
+ */
+class TableMetrics : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QQuickWindow *window READ window WRITE setWindow NOTIFY windowChanged)
+    Q_PROPERTY(qint64 dataCalls READ dataCalls NOTIFY updated)
+    Q_PROPERTY(qint64 cacheHits READ cacheHits NOTIFY updated)
+    Q_PROPERTY(qint64 cacheMisses READ cacheMisses NOTIFY updated)
+    Q_PROPERTY(qint64 queries READ queries NOTIFY updated)
+    Q_PROPERTY(qint64 rowsFetched READ rowsFetched NOTIFY updated)
+    Q_PROPERTY(qint64 bytesHeld READ bytesHeld NOTIFY updated)
+    Q_PROPERTY(qreal frameTime READ frameTime NOTIFY updated)
+public:
+    enum QueryType {
+        CountQuery = 0,
+        PageQuery,
+        ReadQuery,      // one row or one field by key
+        ExecQuery,
+        TransactionQuery,
+        QueryTypes
+    };
+    Q_ENUM(QueryType)
+
+    explicit TableMetrics(QObject *parent = nullptr);
+
+    // nanoseconds of a clock shared by all threads
+    static qint64 now();
+
+    void setWindow(QQuickWindow *window);
+    QQuickWindow *window() const;
+
+    inline void countData() { ++m_dataCalls; ++m_frameDataCalls; }
+    inline void countHit() { ++m_cacheHits; }
+    inline void countMiss() { ++m_cacheMisses; }
+    void addQuery(QueryType type, qint64 started, qint64 elapsed, int rows,
+                  const QString &statement, bool worker = false);
+    void setBytesHeld(qint64 bytes);
+
+    qint64 dataCalls() const { return m_dataCalls; }
+    qint64 cacheHits() const { return m_cacheHits; }
+    qint64 cacheMisses() const { return m_cacheMisses; }
+    qint64 queries() const;
+    qint64 rowsFetched() const { return m_rowsFetched; }
+    qint64 bytesHeld() const { return m_bytesHeld; }
+    // 95th percentile of the sampled frames, ms
+    qreal frameTime() const;
+
+    // everything above with the percentiles of all histograms
+    Q_INVOKABLE QVariantMap snapshot() const;
+    Q_INVOKABLE void reset();
+
+signals:
+    void windowChanged();
+    void updated();
+
+private:
+    /**
+     * Counts of values by powers of two, a percentile is the upper bound
+     * of its bucket, good enough to tell 1 ms from 30 ms.
+     */
+    struct Histogram
+    {
+        enum { Buckets = 48 };
+
+        void add(qint64 value);
+        qint64 percentile(qreal p) const;
+        QVariantMap toMap(qreal scale) const;
+
+        qint64 counts[Buckets] = {};
+        qint64 count = 0;
+        qint64 total = 0;
+        qint64 max = 0;
+    };
+
+    void onFrameSwapped();
+    void notify();
+    static void trace(const char *name, qint64 started, qint64 elapsed, int thread, const QVariantMap &args);
+
+    QPointer<QQuickWindow> m_window;
+    qint64 m_dataCalls = 0;
+    qint64 m_frameDataCalls = 0;
+    qint64 m_cacheHits = 0;
+    qint64 m_cacheMisses = 0;
+    qint64 m_rowsFetched = 0;
+    qint64 m_bytesHeld = 0;
+    qint64 m_lastFrame = 0;
+    qint64 m_lastNotify = 0;
+
+    Histogram m_queries[QueryTypes];    // us
+    Histogram m_frames;                 // us
+    Histogram m_framesDataCalls;
+};
+
+#endif // TABLEMETRICS_H
@@ -23,6 +23,15 @@
  */
 
 #include "tablemodel.h"
+#include "changefeed.h"
+#include "datasource.h"
+#include "exporter.h"
+#include "headermodel.h"
+#include "importer.h"
+#include "queryworker.h"
+#include "relationcache.h"
+#include "rowselection.h"
+#include "schemacache.h"
 #include "sql.h"
 
 #include <QSqlDriver>
@@ -31,192 +40,3465 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QSqlIndex>
-#include <QItemSelectionModel>
+#include <QCache>
+#include <QDateTime>
 #include <QLoggingCategory>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <limits>
 
 Q_LOGGING_CATEGORY(lcTableModel, "app.TableModel")
 
+// upper bound of bound values in one statement, SQLITE_MAX_VARIABLE_NUMBER is 999
+static const int BatchSize = 500;
+
+// edited rows written at once by write behind, before the interval ends
+static const int WriteBehindRows = 256;
+
+// the longest wait before a failed write is tried again, in milliseconds
+static const int MaxRetryInterval = 30000;
+
+// the ItemStatus of a row, "itemStatus" in QML
+static const int StatusRole = Qt::UserRole;
+
+// rows of a page or a fetched batch measured for the column widths
+static const int SampleRows = 32;
+
+// the longest a switch waits for the first page before showing the table
+static const int SwapTimeout = 1000;
+
+// page reader threads of a read only source, each with its own connection
+static const int MaxReaders = 4;
+
+// random keys the filter is tried on for an estimated count
+static const int EstimateSampleRows = 1000;
+
+static QString localFile(const QUrl &url)
+{
+    // qrc:/file.csv is readable as :/file.csv
+    if(url.scheme() == QLatin1String("qrc"))
+        return QLatin1Char(':') + url.path();
+
+    return url.isLocalFile() ? url.toLocalFile() : url.toString();
+}
+
+static QString matchQuery(const QString &text)
+{
+    // every word is a quoted prefix term, FTS5 syntax typed into the
+    // search can not break the query
+    QStringList terms;
+    for (QString word : text.split(QRegularExpression(QStringLiteral("\\s+")), QString::SkipEmptyParts))
+        terms << "\"" + word.replace(QLatin1Char('"'), QLatin1String("\"\"")) + "\"*";
+
+    return terms.join(QLatin1Char(' '));
+}
+
 class TableModelPrivate
 {
-    Q_DECLARE_PUBLIC(TableModel)
-public:
+    Q_DECLARE_PUBLIC(TableModel)
+public:
+    QString escapeField(const QString &field) const;
+    QString escapeTable() const;
+    QString selectFields() const;
+
+    void initKey();
+    int sortIndex() const;
+    QString sortField() const;
+    QString orderBy() const;
+    QString fromClause(QVariantList *values) const;
+    QString deletedClause() const;
+    QString whereClause() const;
+    QString cachedFilter() const;
+    void updateSearch();
+    QString countStatement(QVariantList *values) const;
+    QString pageStatement(int page, QVariantList *values) const;
+    QString exportStatement(QVariantList *values) const;
+    bool countRows(int *count);
+    QString estimateStatement(QVariantList *values) const;
+    int estimateRows() const;
+    void setCountKnown(bool known);
+    QStringList filterColumns() const;
+    QStringList indexStatements();
+    void indexCreated(const QString &statement, bool ok, const QString &errorString);
+    void refreshLater();
+    QSqlDatabase database() const;
+    QSqlDatabase open(const QString &databaseName) const;
+    bool writable(const QString &action);
+    bool switchTable(const QString &databaseName, const QString &tableName);
+    void resetTable(const QString &databaseName, const QString &tableName);
+    void startPrefetch(const QString &tableName);
+    void finishPrefetch();
+    void cancelPrefetch();
+    bool loadPage(int page) const;
+    void storePage(int page, const QVector<QSqlRecord> &rows) const;
+    void pageStored(int page, const QVector<QSqlRecord> &rows);
+    void dropPage(int page);
+    void invalidatePages(int page);
+    QVariant windowValue(int row, int column) const;
+    QVariant lazyValue(int row, int column) const;
+    QList<int> lazyList() const;
+    QString lazyStatement(int keys) const;
+    bool readLazy(const QVariantList &keys) const;
+    void requestLazy(int row, const QVariant &key) const;
+    void postLazy() const;
+    void storeLazy(const QVector<QSqlRecord> &rows) const;
+    void lazyRead(const QueryResult &result);
+    void dropLazyValue(int field, const QString &key);
+    void clearLazyValues();
+    QVariant rowKey(int row) const;
+    QVariant displayValue(int column, const QVariant &value) const;
+    bool exec(const QString &statement, const QVariantList &values) const;
+    bool readRow(const QVariant &key, QSqlRecord *record) const;
+    void patchRow(int row, const QSqlRecord &record);
+
+    bool queueEdit(int row, int column, const QVariant &value);
+    const QVariant *pendingValue(const QString &key, int column) const;
+    void flushEdits(bool wait = false);
+    void editStatements(QStringList *statements, QVector<QVariantList> *batch) const;
+    void editsWritten(const QueryResult &result);
+    QHash<QString, int> cachedRows() const;
+    int itemStatus(int row) const;
+
+    QVariant keyOf(int row) const;
+    bool canBatch() const;
+    bool execByKeys(const QString &statement, const QVector<RowRange> &ranges);
+    int removeRanges(const QVector<RowRange> &ranges);
+    void takeRanges(const QVector<RowRange> &ranges);
+    int recoverRanges(const QVector<RowRange> &ranges);
+    void reportError(const QString &message);
+
+    void setProfile(const SqlProfile &profile);
+
+    void updateProjection();
+    void updateRoles();
+    void resetGeometry();
+    void measurePage(int page) const;
+    void measureRows(int first, int last);
+    void selectionChanged(int first, int last);
+    void saveSelection();
+    void restoreSelection();
+    inline int fieldOf(int column) const
+    {
+        return projection.isEmpty() ? column : projection.value(column, -1);
+    }
+    inline int roleColumn(int role) const
+    {
+        const int column = role - Qt::UserRole - 1;
+        return column >= 0 && column < roleFields ? column : -1;
+    }
+
+    QString sourceKey() const;
+    bool attachSource();
+    void detachSource();
+    void setSource(const QSharedPointer<DataSource> &shared);
+    void sourceCounted(int count);
+    void sourceReset(QObject *origin);
+    void sourceRowsChanged(QObject *origin, int first, int last);
+    void sourceRowsRemoved(QObject *origin, int first, int last);
+    void sourceRowsInserted(QObject *origin, int first, int last);
+
+    void updateFeed();
+    void applyChanges(const ChangeFeed::ChangeSet &logged, qint64 seq);
+    bool rereadRows(const QHash<qint64, int> &rows, QVector<int> *removed);
+
+    QueryWorker *worker() const;
+    void post(QueryTask task) const;
+    void requestPage(int page) const;
+    void onQueryFinished(const QueryResult &result);
+    void updateLoading();
+
+    QString databaseName;
+    QString tableName;
+    QString errorString;
+    RowSelection selection;
+    // the selection by key across the resets of cached mode, e.g. the
+    // select after every write
+    QSet<QString> selectedKeys;
+    int selectedFetched = 0;
+    bool selectedAll = false;
+    bool restoreQueued = false;
+    HeaderModel *horizontalHeader = nullptr;
+    HeaderModel *verticalHeader = nullptr;
+
+    // built once per table, the role of a field is Qt::UserRole + 1 + its
+    // index in the record
+    QHash<int, QByteArray> roles;
+    int roleFields = 0;
+    int deletedAtColumn = -1;
+    int stateColumn = -1;
+
+    // tables with a deleted_at column delete softly, showDeleted reads
+    // the trash instead of the rows in use
+    bool showDeleted = false;
+    inline bool softDelete() const { return deletedAtColumn >= 0; }
+
+    // windowed fetch mode
+    // foreign keys resolved without a JOIN
+    mutable RelationCache relations;
+
+    TableModel::FetchMode fetchMode = TableModel::CachedFetch;
+    int rowCount = 0;
+    int pageSize = 256;
+    int cachedPages = 32;
+
+    // the page cache and the select queries, shared by the models with
+    // the same statement
+    QSharedPointer<DataSource> source;
+    QString keyField;
+    int keyColumn = -1;
+
+    // windowed projection: model column to record field, the other fields
+    // are selected as NULL. Large projected fields are read per row
+    QStringList columns;
+    QVector<int> projection;
+    QSet<int> lazyFields;
+    mutable QCache<QPair<int, QString>, QVariant> lazyValues { 16 * 1024 * 1024 };
+    mutable QHash<QString, int> lazyPending;    // row by key, read on the worker
+    mutable QVariantList lazyWanted;            // keys to post once back in the event loop
+    int lazyGeneration = 0;                     // reads of dropped values are ignored
+
+    // sorting and filtering, pushed into ORDER BY and WHERE
+    int sortColumn = -1;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    QString filter;
+    bool autoIndex = false;
+    QSet<QString> indexed;                  // created already
+    QHash<QString, QString> indexing;       // index name by CREATE statement
+    bool completed = false;
+    bool refreshQueued = false;
+
+    // opened read only and immutable, nothing is edited or written
+    bool readOnly = false;
+
+    // rows written by other connections and processes, from the log
+    bool liveSync = false;
+    QSharedPointer<ChangeFeed> feed;
+    QString feedTable;                          // tracked by the feed
+
+    // :/migrations are applied to the file, not only to the memory database
+    bool migrate = false;
+
+    // a switch to a table of the same database reads the first page by a
+    // hidden model, the views show the old rows until the reset
+    bool prefetch = true;
+    TableModel *prefetcher = nullptr;
+    QTimer swapTimer;
+
+    // write behind: edits coalesced by row key and column, the rows of
+    // flushing are in the transaction on the worker
+    struct PendingEdit
+    {
+        QVariant key;
+        QMap<int, QVariant> values;
+        QMap<int, QVariant> stored;     // the values in the table until written
+    };
+    bool writeBehind = false;
+    QMap<QString, PendingEdit> edits;
+    QMap<QString, PendingEdit> flushing;
+    QHash<QString, int> editStatus;
+    QTimer flushTimer;
+    QTimer retryTimer;          // after a failed write, backing off
+    int writeFailures = 0;
+
+    // full text search through the <table>_fts table, ranked by bm25()
+    QString searchText;
+    QString searchQuery;
+    QString ftsTable;
+
+    // asynchronous loading, counted and paged by the source, written
+    // edits and lazy fields on the first worker of the pool of the
+    // database; results of this model carry its owner id
+    bool asynchronous = false;
+    bool countKnown = false;
+    TableModel::CountStrategy countStrategy = TableModel::ExactCount;
+    bool loading = false;
+    mutable QSharedPointer<QueryPool> pool;
+    int owner = QueryPool::nextOwner();
+
+    // run on the worker thread, deleted once finished
+    Importer *importer = nullptr;
+    Exporter *exporter = nullptr;
+
+    TableMetrics *metrics = nullptr;
+
+    // auto sized widths, every page loaded is sampled once
+    ColumnGeometry *geometry = nullptr;
+    mutable QSet<int> measuredPages;
+
+    TableModel *q_ptr = nullptr;
+};
+
+QString TableModelPrivate::escapeField(const QString &field) const
+{
+    return database().driver()->escapeIdentifier(field, QSqlDriver::FieldName);
+}
+
+QString TableModelPrivate::escapeTable() const
+{
+    Q_Q(const TableModel);
+    return database().driver()->escapeIdentifier(q->tableName(), QSqlDriver::TableName);
+}
+
+QString TableModelPrivate::selectFields() const
+{
+    Q_Q(const TableModel);
+    QStringList fields;
+    const QSqlRecord rec = q->record();
+    const int sorted = sortIndex();
+    for (int i = 0; i < rec.count(); ++i)
+    {
+        // records keep the layout of the table, fields out of the
+        // projection cost no I/O and no cache memory as NULL
+        const bool selected = (projection.isEmpty() || projection.contains(i)) && !lazyFields.contains(i);
+        if(selected || i == keyColumn || i == sorted)
+            fields << escapeField(rec.fieldName(i));
+        else
+            fields << QStringLiteral("NULL");
+    }
+
+    // tables without a single column primary key are paged by rowid,
+    // which is fetched behind the table columns
+    if(keyColumn < 0)
+        fields << keyField;
+
+    return fields.join(", ");
+}
+
+void TableModelPrivate::initKey()
+{
+    Q_Q(TableModel);
+    const QSqlIndex index = q->primaryKey();
+    if(index.count() == 1)
+    {
+        keyField = escapeField(index.fieldName(0));
+        keyColumn = q->record().indexOf(index.fieldName(0));
+    }
+    else
+    {
+        keyField = QStringLiteral("rowid");
+        keyColumn = -1;
+    }
+}
+
+int TableModelPrivate::sortIndex() const
+{
+    Q_Q(const TableModel);
+    const int field = sortColumn < 0 ? -1 : fieldOf(sortColumn);
+    return field < q->record().count() ? field : -1;
+}
+
+QString TableModelPrivate::sortField() const
+{
+    Q_Q(const TableModel);
+    const int field = sortIndex();
+    if(field < 0)
+        return QString();
+
+    return escapeField(q->record().fieldName(field));
+}
+
+QString TableModelPrivate::orderBy() const
+{
+    // the key follows the sort column, keys make the order total
+    const QString direction = sortOrder == Qt::DescendingOrder ? " DESC" : QString();
+    const QString field = sortField();
+    if(field.isEmpty())
+        return searchQuery.isEmpty() ? keyField : "fts.fts_rank, " + keyField;
+
+    return field + direction + ", " + keyField + direction;
+}
+
+QString TableModelPrivate::fromClause(QVariantList *values) const
+{
+    if(searchQuery.isEmpty())
+        return escapeTable();
+
+    // the matching rowids joined with their rank
+    const QString fts = database().driver()->escapeIdentifier(ftsTable, QSqlDriver::TableName);
+    *values << searchQuery;
+
+    return escapeTable() + " JOIN (SELECT rowid AS fts_rowid, bm25(" + fts + ") AS fts_rank FROM "
+            + fts + " WHERE " + fts + " MATCH ?) AS fts ON fts.fts_rowid = "
+            + escapeTable() + "." + keyField;
+}
+
+QString TableModelPrivate::deletedClause() const
+{
+    // the same terms as the partial indexes, so SQLite can use them
+    if(!softDelete())
+        return QString();
+
+    return escapeField("deleted_at") + (showDeleted ? " IS NOT NULL" : " IS NULL");
+}
+
+QString TableModelPrivate::whereClause() const
+{
+    QStringList where;
+    const QString deleted = deletedClause();
+    if(!deleted.isEmpty())
+        where << deleted;
+    if(!filter.isEmpty())
+        where << "(" + filter + ")";
+
+    return where.join(" AND ");
+}
+
+QString TableModelPrivate::cachedFilter() const
+{
+    const QString where = whereClause();
+    if(searchQuery.isEmpty())
+        return where;
+
+    // QSqlTableModel takes no bound values, the query is a literal
+    const QString fts = database().driver()->escapeIdentifier(ftsTable, QSqlDriver::TableName);
+    QString match = searchQuery;
+    match.replace(QLatin1Char('\''), QLatin1String("''"));
+
+    const QString search = escapeTable() + "." + keyField + " IN (SELECT rowid FROM " + fts
+            + " WHERE " + fts + " MATCH '" + match + "')";
+
+    return where.isEmpty() ? search : where + " AND " + search;
+}
+
+void TableModelPrivate::updateSearch()
+{
+    Q_Q(TableModel);
+    searchQuery.clear();
+    ftsTable.clear();
+
+    const QString query = matchQuery(searchText);
+    if(query.isEmpty())
+        return;
+
+    const QString fts = q->tableName() + "_fts";
+    if(!SchemaCache::hasTable(database(), fts))
+    {
+        reportError("No full text index '" + fts + "' for table " + q->tableName());
+        return;
+    }
+
+    ftsTable = fts;
+    searchQuery = query;
+}
+
+QString TableModelPrivate::countStatement(QVariantList *values) const
+{
+    QString statement = "SELECT COUNT(*) FROM " + fromClause(values);
+    const QString where = whereClause();
+    if(!where.isEmpty())
+        statement += " WHERE " + where;
+
+    return statement;
+}
+
+QString TableModelPrivate::pageStatement(int page, QVariantList *values) const
+{
+    // continue from the nearest page whose first key is known, only the
+    // pages in between (usually none) are skipped by OFFSET. Ranked search
+    // results continue from the rank and key of the last row
+    const int from = source->pages.nearestAnchor(page);
+    QVariantList anchor;
+    const bool keyset = from > 0 && source->pages.anchor(from, &anchor);
+
+    const QString tables = fromClause(values);
+
+    QStringList where;
+    const QString condition = whereClause();
+    if(!condition.isEmpty())
+        where << condition;
+
+    const QString field = sortField();
+    if(keyset && field.isEmpty() && !searchQuery.isEmpty())
+    {
+        where << "(fts.fts_rank, " + keyField + ") > (?, ?)";
+        *values << anchor.value(0) << anchor.value(1);
+    }
+    else if(keyset && field.isEmpty())
+    {
+        where << keyField + " > ?";
+        *values << anchor.value(0);
+    }
+    else if(keyset)
+    {
+        // NULL sorts first and compares to nothing, a descending page
+        // continues into the NULLs at the end
+        const QString row = "(" + field + ", " + keyField + ")";
+        where << (sortOrder == Qt::DescendingOrder
+                  ? "(" + row + " < (?, ?) OR " + field + " IS NULL)"
+                  : row + " > (?, ?)");
+        *values << anchor.value(0) << anchor.value(1);
+    }
+
+    // the rank of a match follows the fields, the anchor of the next page
+    QString statement = "SELECT " + selectFields() + (searchQuery.isEmpty() ? QString() : ", fts.fts_rank")
+            + " FROM " + tables;
+    if(!where.isEmpty())
+        statement += " WHERE " + where.join(" AND ");
+    statement += " ORDER BY " + orderBy() + " LIMIT ? OFFSET ?";
+    *values << source->pages.pageSize() << (page - from) * source->pages.pageSize();
+
+    return statement;
+}
+
+QString TableModelPrivate::exportStatement(QVariantList *values) const
+{
+    Q_Q(const TableModel);
+    // what QSqlRelationalTableModel selects, relations, filter and sort
+    // included
+    if(fetchMode == TableModel::CachedFetch)
+        return q->selectStatement();
+
+    QStringList fields;
+    const QSqlRecord rec = q->record();
+    for (int i = 0; i < rec.count(); ++i)
+        fields << escapeField(rec.fieldName(i));
+
+    QString statement = "SELECT " + fields.join(", ") + " FROM " + fromClause(values);
+    const QString where = whereClause();
+    if(!where.isEmpty())
+        statement += " WHERE " + where;
+
+    return statement + " ORDER BY " + orderBy();
+}
+
+bool TableModelPrivate::countRows(int *count)
+{
+    QVariantList values;
+    const QString statement = countStatement(&values);
+    const qint64 started = TableMetrics::now();
+    QSqlQuery query = Sql::prepare(statement, database());
+    for (const QVariant &value : values)
+        query.addBindValue(value);
+
+    const bool ok = query.exec() && query.next();
+    metrics->addQuery(TableMetrics::CountQuery, started, TableMetrics::now() - started, 0, statement);
+    if(!ok)
+    {
+        reportError("Count record error " + query.lastError().text());
+        *count = 0;
+        return false;
+    }
+
+    *count = query.value(0).toInt();
+    query.finish();
+    return true;
+}
+
+QString TableModelPrivate::estimateStatement(QVariantList *values) const
+{
+    Q_Q(const TableModel);
+    // the ranked matches of a search are counted only
+    if(!searchQuery.isEmpty())
+        return QString();
+
+    const QString table = escapeTable();
+    const SchemaCache::Table info = SchemaCache::table(database(), q->tableName());
+    const bool integerKey = keyColumn < 0
+            || info.types.value(q->record().fieldName(keyColumn)).contains("INT");
+    const bool analyzed = SchemaCache::analyzed(database());
+    if(!analyzed && !integerKey)
+        return QString();
+
+    // the first number of a stat is the rows of the table, or of the
+    // index, which is less for a partial one; not analyzed, the range of
+    // an integer key by two index lookups
+    QStringList totals;
+    if(analyzed)
+    {
+        totals << "(SELECT MAX(CAST(stat AS INTEGER)) FROM sqlite_stat1 WHERE tbl = ? COLLATE NOCASE)";
+        *values << q->tableName();
+    }
+    if(integerKey)
+        totals << QString("(SELECT MAX(%1) FROM %2) - (SELECT MIN(%1) FROM %2) + 1").arg(keyField, table);
+    totals << "-1";
+    const QString total = "COALESCE(" + totals.join(", ") + ")";
+
+    const QString where = whereClause();
+    if(where.isEmpty())
+        return "SELECT MIN(" + total + ", 2147483647)";
+
+    // the share of the rows at random keys that passes the filter, keys
+    // at gaps find no row and are left out; a small table is counted
+    const QString sampleKey = integerKey ? keyField : QStringLiteral("rowid");
+    return QString("WITH RECURSIVE bounds(size, low, span) AS ("
+                   "SELECT %1, (SELECT MIN(%2) FROM %3), (SELECT MAX(%2) FROM %3) - (SELECT MIN(%2) FROM %3) + 1), "
+                   "sample(n, sample_key) AS (SELECT 0, NULL UNION ALL "
+                   "SELECT n + 1, low + abs(random() % span) FROM sample, bounds WHERE n < %5) "
+                   "SELECT CASE WHEN size < 0 THEN -1 "
+                   "WHEN size <= %5 THEN (SELECT COUNT(*) FROM %3 WHERE %4) "
+                   "ELSE MIN(CAST(size * passed / MAX(1, sampled) AS INTEGER), 2147483647) END "
+                   "FROM bounds, (SELECT COUNT(*) AS sampled, TOTAL((%4) IS 1) AS passed FROM %3 "
+                   "WHERE %2 IN (SELECT sample_key FROM sample))")
+            .arg(total, sampleKey, table, where, QString::number(EstimateSampleRows));
+}
+
+int TableModelPrivate::estimateRows() const
+{
+    QVariantList values;
+    const QString statement = estimateStatement(&values);
+    if(statement.isEmpty())
+        return -1;
+
+    const qint64 started = TableMetrics::now();
+    QSqlQuery query = Sql::prepare(statement, database());
+    for (const QVariant &value : values)
+        query.addBindValue(value);
+
+    const int estimate = query.exec() && query.next() ? query.value(0).toInt() : -1;
+    query.finish();
+    metrics->addQuery(TableMetrics::CountQuery, started, TableMetrics::now() - started, 0, statement);
+    return estimate;
+}
+
+void TableModelPrivate::setCountKnown(bool known)
+{
+    Q_Q(TableModel);
+    if(countKnown == known)
+        return;
+
+    countKnown = known;
+    emit q->countExactChanged();
+}
+
+QStringList TableModelPrivate::filterColumns() const
+{
+    Q_Q(const TableModel);
+    // the table fields named in the filter, string literals left out
+    static const QRegularExpression literal(QStringLiteral("'(?:[^']|'')*'"));
+    static const QRegularExpression identifier(QStringLiteral("[A-Za-z_][A-Za-z0-9_]*|`[^`]+`|\"[^\"]+\"|\\[[^\\]]+\\]"));
+
+    QString text = filter;
+    text.replace(literal, QStringLiteral("''"));
+
+    const QSqlRecord rec = q->record();
+    QStringList columns;
+    QRegularExpressionMatchIterator it = identifier.globalMatch(text);
+    while (it.hasNext())
+    {
+        QString name = it.next().captured(0);
+        if(name.length() > 2 && !name.at(0).isLetter() && name.at(0) != QLatin1Char('_'))
+            name = name.mid(1, name.length() - 2);
+
+        if(rec.indexOf(name) >= 0 && !columns.contains(name))
+            columns << name;
+    }
+
+    return columns;
+}
+
+QStringList TableModelPrivate::indexStatements()
+{
+    Q_Q(TableModel);
+    QStringList columns = filterColumns();
+    if(sortIndex() >= 0)
+        columns.prepend(q->record().fieldName(sortIndex()));
+
+    // the key is in every index already
+    QStringList statements;
+    for (const QString &column : columns)
+    {
+        if(column.compare(q->record().fieldName(keyColumn), Qt::CaseInsensitive) == 0)
+            continue;
+
+        // soft deleted tables index the rows of the current view only
+        const QString deleted = deletedClause();
+        const QString name = q->tableName() + "_" + column
+                + (deleted.isEmpty() ? QString() : showDeleted ? "_trash" : "_alive") + "_idx";
+        if(indexed.contains(name))
+            continue;
+
+        // the name is taken as indexed once the statement succeeds, a
+        // failed or dropped one is issued again by the next refresh
+        QString statement = QString("CREATE INDEX IF NOT EXISTS %1 ON %2 (%3)")
+                .arg(escapeField(name), escapeTable(), escapeField(column));
+        if(!deleted.isEmpty())
+            statement += " WHERE " + deleted;
+        indexing.insert(statement, name);
+        statements << statement;
+    }
+
+    return statements;
+}
+
+void TableModelPrivate::indexCreated(const QString &statement, bool ok, const QString &errorString)
+{
+    const QString name = indexing.take(statement);
+    if(ok)
+        indexed.insert(name);
+    else
+        reportError("Create index error " + name + (errorString.isEmpty() ? QString() : " " + errorString));
+}
+
+void TableModelPrivate::refreshLater()
+{
+    // sort column, order and filter set together select once
+    if(!completed || refreshQueued)
+        return;
+
+    // a refresh in between takes the queued one back
+    refreshQueued = true;
+    QMetaObject::invokeMethod(q_ptr, [this]() {
+        if(!refreshQueued)
+            return;
+        refreshQueued = false;
+        q_ptr->refresh();
+    }, Qt::QueuedConnection);
+}
+
+QSqlDatabase TableModelPrivate::database() const
+{
+    Q_Q(const TableModel);
+    // pages are read through the pooled connection of the database, which
+    // caches their statements; QSqlTableModel keeps its rows on the
+    // connection of the model
+    if(fetchMode != TableModel::WindowedFetch)
+        return q->database();
+
+    return readOnly ? Sql::readOnlyDatabase(databaseName) : Sql::database(databaseName);
+}
+
+QSqlDatabase TableModelPrivate::open(const QString &databaseName) const
+{
+    Q_Q(const TableModel);
+    // a file gets the migrations only when the model asks for them, also
+    // when the connection is open on it already
+    if(migrate && !readOnly)
+        Sql::enableMigrations(databaseName);
+
+    // only the connection of this model follows the database name
+    QSqlDatabase db = q->database();
+    const QString name = readOnly ? Sql::readOnlyName(databaseName) : Sql::resolveName(databaseName);
+    if(!db.isOpen() || db.databaseName() != name)
+        Sql::reopen(db, name);
+    else
+        Sql::migrate(db);
+    return db;
+}
+
+bool TableModelPrivate::writable(const QString &action)
+{
+    Q_Q(TableModel);
+    if(!readOnly)
+        return true;
+
+    reportError(QString("Can not %1, table '%2' is read only").arg(action, q->tableName()));
+    return false;
+}
+
+bool TableModelPrivate::switchTable(const QString &databaseName, const QString &tableName)
+{
+    Q_Q(TableModel);
+    flushEdits(true);
+    cancelPrefetch();
+
+    // the table is looked up through the pooled connection of the
+    // database, the connection of this model moves only when it is there
+    if(migrate && !readOnly)
+        Sql::enableMigrations(databaseName);
+    QSqlDatabase db = readOnly ? Sql::readOnlyDatabase(databaseName) : Sql::database(databaseName);
+    Sql::migrate(db);
+    SchemaCache::validate(db);
+    if(!db.isOpen() || !SchemaCache::hasTable(db, tableName))
+    {
+        reportError(QString("Can not open table '%1' in '%2'").arg(tableName, db.databaseName()));
+        return false;
+    }
+    open(databaseName);
+
+    // a table of the same database is shown with its first page; another
+    // database at once, the connection of the model is on it already
+    if(prefetch && asynchronous && fetchMode == TableModel::WindowedFetch
+            && databaseName == this->databaseName && tableName != q->tableName())
+    {
+        startPrefetch(tableName);
+        return true;
+    }
+
+    resetTable(databaseName, tableName);
+    return true;
+}
+
+void TableModelPrivate::resetTable(const QString &databaseName, const QString &tableName)
+{
+    Q_Q(TableModel);
+    // one reset for the table, its roles and the first select, the
+    // resets and row signals in between are nested into it
+    q->beginResetModel();
+    this->databaseName = databaseName;
+    this->tableName = tableName;
+    detachSource();
+    q->QSqlRelationalTableModel::setTable(tableName);
+    Sql::invalidateStatements();
+    relations.clear();
+    clearLazyValues();
+    rowCount = 0;
+    setCountKnown(false);
+    updateRoles();
+    initKey();
+    q->refresh();
+    updateFeed();
+    q->endResetModel();
+}
+
+void TableModelPrivate::startPrefetch(const QString &tableName)
+{
+    Q_Q(TableModel);
+    // the same select of the other table, its source is taken over by the
+    // reset and already holds the first page
+    prefetcher = new TableModel(q);
+    prefetcher->classBegin();
+    prefetcher->setDatabaseName(databaseName);
+    prefetcher->setReadOnly(readOnly);
+    prefetcher->setFetchMode(fetchMode);
+    prefetcher->setPageSize(q->pageSize());
+    prefetcher->setCachedPages(q->cachedPages());
+    prefetcher->setColumns(columns);
+    prefetcher->setSortColumn(sortColumn);
+    prefetcher->setSortOrder(sortOrder);
+    prefetcher->setFilter(filter);
+    prefetcher->setSearchText(searchText);
+    prefetcher->setShowDeleted(showDeleted);
+    prefetcher->setCountStrategy(countStrategy);
+    prefetcher->setAsynchronous(true);
+    prefetcher->setPrefetch(false);
+    prefetcher->setTable(tableName);
+    prefetcher->componentComplete();
+
+    // finished once back in the event loop, never inside a signal of the
+    // source being taken over
+    const QPointer<TableModel> hidden = prefetcher;
+    const auto finishLater = [this, hidden]() {
+        QMetaObject::invokeMethod(q_ptr, [this, hidden]() {
+            if(hidden && hidden == prefetcher)
+                finishPrefetch();
+        }, Qt::QueuedConnection);
+    };
+
+    const QSharedPointer<DataSource> next = prefetcher->d_func()->source;
+    QObject::connect(next.data(), &DataSource::pageStored, prefetcher, [finishLater](int page) {
+        if(page == 0)
+            finishLater();
+    });
+    QObject::connect(next.data(), &DataSource::counted, prefetcher, [finishLater](int count) {
+        if(count == 0)
+            finishLater();
+    });
+    QObject::connect(prefetcher, &TableModel::error, q, finishLater);
+
+    if(next->pages.contains(0) || next->count == 0)
+        finishLater();
+    else
+        swapTimer.start();
+}
+
+void TableModelPrivate::finishPrefetch()
+{
+    Q_Q(TableModel);
+    if(!prefetcher)
+        return;
+
+    // the hidden model holds the source until the reset has taken it
+    TableModel *hidden = prefetcher;
+    prefetcher = nullptr;
+    swapTimer.stop();
+    resetTable(databaseName, hidden->tableName());
+    hidden->deleteLater();
+    emit q->tableChanged();
+}
+
+void TableModelPrivate::cancelPrefetch()
+{
+    if(!prefetcher)
+        return;
+
+    swapTimer.stop();
+    prefetcher->deleteLater();
+    prefetcher = nullptr;
+}
+
+bool TableModelPrivate::loadPage(int page) const
+{
+    QVariantList values;
+    const QString statement = pageStatement(page, &values);
+
+    const qint64 started = TableMetrics::now();
+    QSqlQuery query = Sql::prepare(statement, database());
+    for (const QVariant &value : values)
+        query.addBindValue(value);
+
+    if(!query.exec())
+    {
+        qWarning(lcTableModel) << "Read page error" << query.lastError().text();
+        return false;
+    }
+
+    QVector<QSqlRecord> rows;
+    rows.reserve(source->pages.pageSize());
+    while (query.next())
+        rows.append(query.record());
+    query.finish();
+    metrics->addQuery(TableMetrics::PageQuery, started, TableMetrics::now() - started, rows.count(), statement);
+
+    storePage(page, rows);
+    return !rows.isEmpty();
+}
+
+void TableModelPrivate::storePage(int page, const QVector<QSqlRecord> &rows) const
+{
+    // every view of the source sees the page by pageStored()
+    source->store(page, rows);
+}
+
+void TableModelPrivate::pageStored(int page, const QVector<QSqlRecord> &rows)
+{
+    Q_Q(TableModel);
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+
+    // edits not written yet are shown over the rows read
+    if(!edits.isEmpty() || !flushing.isEmpty())
+    {
+        const int first = source->pages.firstRow(page);
+        for (int i = 0; i < rows.count(); ++i)
+        {
+            const QString key = rows.at(i).value(keyIndex).toString();
+            for (const QMap<QString, PendingEdit> *queue : { &flushing, &edits })
+            {
+                QMap<QString, PendingEdit>::const_iterator edit = queue->constFind(key);
+                if(edit == queue->constEnd())
+                    continue;
+
+                for (QMap<int, QVariant>::const_iterator it = edit->values.constBegin(); it != edit->values.constEnd(); ++it)
+                    source->pages.setValue(first + i, it.key(), it.value());
+            }
+        }
+    }
+    if(rows.count() == source->pages.pageSize())
+    {
+        // no anchor after a NULL sort value, that page is read by OFFSET
+        QVariantList anchor;
+        if(!sortField().isEmpty())
+            anchor << rows.last().value(sortIndex());
+        else if(!searchQuery.isEmpty())
+            anchor << rows.last().value(q->record().count() + (keyColumn < 0 ? 1 : 0));
+        anchor << rows.last().value(keyIndex);
+        if(!anchor.first().isNull())
+            source->pages.setAnchor(page + 1, anchor);
+    }
+
+    measurePage(page);
+    metrics->setBytesHeld(source->pages.bytesHeld());
+    qDebug(lcTableModel) << "load page" << page << "rows:" << rows.count();
+}
+
+void TableModelPrivate::dropPage(int page)
+{
+    source->pages.remove(page);
+    ++source->serial;
+}
+
+void TableModelPrivate::invalidatePages(int page)
+{
+    source->pages.invalidateFrom(page);
+    ++source->serial;
+}
+
+QVariant TableModelPrivate::windowValue(int row, int column) const
+{
+    if(lazyFields.contains(column))
+        return lazyValue(row, column);
+
+    QVariant value;
+    if(source->pages.value(row, column, &value))
+    {
+        metrics->countHit();
+        return value;
+    }
+
+    metrics->countMiss();
+    if(asynchronous)
+    {
+        requestPage(source->pages.pageOf(row));
+        return QVariant();
+    }
+
+    if(!loadPage(source->pages.pageOf(row)))
+        return QVariant();
+
+    source->pages.value(row, column, &value);
+    return value;
+}
+
+QVariant TableModelPrivate::lazyValue(int row, int column) const
+{
+    Q_Q(const TableModel);
+    // the key comes with the page, the large values by a query of their own
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+    QVariant key;
+    if(!source->pages.value(row, keyIndex, &key))
+    {
+        windowValue(row, keyIndex);
+        if(!source->pages.value(row, keyIndex, &key))
+            return QVariant();
+    }
+
+    if(const QVariant *value = pendingValue(key.toString(), column))
+        return *value;
+
+    const QPair<int, QString> id = qMakePair(column, key.toString());
+    if(const QVariant *value = lazyValues.object(id))
+        return *value;
+
+    // the misses of one paint are read together on the worker
+    if(asynchronous)
+    {
+        requestLazy(row, key);
+        return QVariant();
+    }
+
+    // the misses of the page are read together
+    QVariantList keys;
+    for (const QVariant &pageKey : source->pages.column(source->pages.pageOf(row), keyIndex))
+    {
+        if(!lazyValues.contains(qMakePair(column, pageKey.toString())))
+            keys << pageKey;
+    }
+    if(!readLazy(keys))
+        return QVariant();
+
+    const QVariant *value = lazyValues.object(id);
+    return value ? *value : QVariant();
+}
+
+QList<int> TableModelPrivate::lazyList() const
+{
+    QList<int> fields = lazyFields.values();
+    std::sort(fields.begin(), fields.end());
+    return fields;
+}
+
+QString TableModelPrivate::lazyStatement(int keys) const
+{
+    Q_Q(const TableModel);
+    // the key first, the large fields in the order of the record
+    QStringList fields;
+    fields << keyField;
+    for (int field : lazyList())
+        fields << escapeField(q->record().fieldName(field));
+
+    QStringList holders;
+    for (int i = 0; i < keys; ++i)
+        holders << QStringLiteral("?");
+
+    return "SELECT " + fields.join(", ") + " FROM " + escapeTable()
+            + " WHERE " + keyField + " IN (" + holders.join(",") + ")";
+}
+
+bool TableModelPrivate::readLazy(const QVariantList &keys) const
+{
+    for (int i = 0; i < keys.count(); i += BatchSize)
+    {
+        const QVariantList batch = keys.mid(i, BatchSize);
+        const QString statement = lazyStatement(batch.count());
+        const qint64 started = TableMetrics::now();
+        QSqlQuery query = Sql::prepare(statement, database());
+        for (const QVariant &key : batch)
+            query.addBindValue(key);
+
+        QVector<QSqlRecord> rows;
+        const bool ok = query.exec();
+        while (ok && query.next())
+            rows << query.record();
+        metrics->addQuery(TableMetrics::ReadQuery, started, TableMetrics::now() - started, rows.count(), statement);
+        if(!ok)
+        {
+            qWarning(lcTableModel) << "Read field error" << query.lastError().text();
+            return false;
+        }
+
+        query.finish();
+        storeLazy(rows);
+    }
+
+    return true;
+}
+
+void TableModelPrivate::requestLazy(int row, const QVariant &key) const
+{
+    if(lazyPending.contains(key.toString()))
+        return;
+
+    lazyPending.insert(key.toString(), row);
+    lazyWanted << key;
+
+    // may be called from data(), the keys of the whole paint go at once
+    if(lazyWanted.count() == 1)
+    {
+        QMetaObject::invokeMethod(q_ptr, [this]() {
+            postLazy();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void TableModelPrivate::postLazy() const
+{
+    for (int i = 0; i < lazyWanted.count(); i += BatchSize)
+    {
+        QueryTask task;
+        task.kind = QueryTask::Read;
+        task.generation = lazyGeneration;
+        task.databaseName = database().databaseName();
+        task.values = lazyWanted.mid(i, BatchSize);
+        task.statement = lazyStatement(task.values.count());
+        task.owner = task.origin = owner;
+        worker()->post(task);
+    }
+    lazyWanted.clear();
+}
+
+void TableModelPrivate::storeLazy(const QVector<QSqlRecord> &rows) const
+{
+    const QList<int> fields = lazyList();
+    for (const QSqlRecord &record : rows)
+    {
+        const QString key = record.value(0).toString();
+        for (int i = 0; i < fields.count(); ++i)
+        {
+            // the cost is about the bytes held
+            const QVariant value = record.value(i + 1);
+            const int cost = value.type() == QVariant::ByteArray ? value.toByteArray().size()
+                                                                 : value.toString().size() * 2;
+            lazyValues.insert(qMakePair(fields.at(i), key), new QVariant(value), qMax(1, cost));
+        }
+    }
+}
+
+void TableModelPrivate::lazyRead(const QueryResult &result)
+{
+    Q_Q(TableModel);
+    // values dropped meanwhile are read again by the next paint
+    if(result.generation != lazyGeneration)
+        return;
+
+    if(!result.ok)
+    {
+        reportError("Read field error " + result.errorString);
+        lazyPending.clear();
+        return;
+    }
+
+    storeLazy(result.rows);
+
+    // the rows the keys were shown at, unless rows moved meanwhile
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+    int first = rowCount;
+    int last = -1;
+    for (const QSqlRecord &record : result.rows)
+    {
+        const QString key = record.value(0).toString();
+        QHash<QString, int>::iterator it = lazyPending.find(key);
+        if(it == lazyPending.end())
+            continue;
+
+        const int row = it.value();
+        lazyPending.erase(it);
+        QVariant shown;
+        if(row < rowCount && source->pages.value(row, keyIndex, &shown) && shown.toString() == key)
+        {
+            first = qMin(first, row);
+            last = qMax(last, row);
+        }
+    }
+
+    if(last >= 0)
+        emit q->dataChanged(q->index(first, 0), q->index(last, q->columnCount() - 1));
+}
+
+void TableModelPrivate::dropLazyValue(int field, const QString &key)
+{
+    lazyValues.remove(qMakePair(field, key));
+
+    // a read in flight may hold the value before the write
+    if(lazyPending.contains(key))
+    {
+        ++lazyGeneration;
+        lazyPending.clear();
+        lazyWanted.clear();
+    }
+}
+
+void TableModelPrivate::clearLazyValues()
+{
+    lazyValues.clear();
+    lazyPending.clear();
+    lazyWanted.clear();
+    ++lazyGeneration;
+}
+
+QVariant TableModelPrivate::rowKey(int row) const
+{
+    Q_Q(const TableModel);
+    const int column = keyColumn < 0 ? q->record().count() : keyColumn;
+
+    // writes need the key now, also in asynchronous mode
+    QVariant value;
+    if(!source->pages.value(row, column, &value) && loadPage(source->pages.pageOf(row)))
+        source->pages.value(row, column, &value);
+
+    return value;
+}
+
+QVariant TableModelPrivate::displayValue(int column, const QVariant &value) const
+{
+    if(!relations.hasRelation(column))
+        return value;
+
+    return relations.display(column, value, database());
+}
+
+bool TableModelPrivate::exec(const QString &statement, const QVariantList &values) const
+{
+    Q_Q(const TableModel);
+    const qint64 started = TableMetrics::now();
+    QSqlQuery query = Sql::prepare(statement, database());
+    for (const QVariant &value : values)
+        query.addBindValue(value);
+
+    const bool ok = query.exec();
+    metrics->addQuery(TableMetrics::ExecQuery, started, TableMetrics::now() - started, 0, statement);
+    if(!ok)
+    {
+        qWarning(lcTableModel) << statement << query.lastError().text();
+        return false;
+    }
+
+    query.finish();
+    RelationCache::invalidate(q->tableName());
+    return true;
+}
+
+QVariant TableModelPrivate::keyOf(int row) const
+{
+    Q_Q(const TableModel);
+    if(fetchMode == TableModel::WindowedFetch)
+        return rowKey(row);
+
+    if(keyColumn < 0)
+        return QVariant();
+
+    return q->QSqlRelationalTableModel::data(q->index(row, keyColumn), Qt::EditRole);
+}
+
+bool TableModelPrivate::canBatch() const
+{
+    // rows cached by QSqlTableModel carry no rowid
+    return fetchMode == TableModel::WindowedFetch || keyColumn >= 0;
+}
+
+bool TableModelPrivate::execByKeys(const QString &statement, const QVector<RowRange> &ranges)
+{
+    Q_Q(TableModel);
+    QVariantList keys;
+    for (const RowRange &range : ranges)
+    {
+        for (int row = range.first; row <= range.second; ++row)
+        {
+            const QVariant key = keyOf(row);
+            if(!key.isValid())
+            {
+                reportError(QString("No key for row %1 of table '%2'").arg(row).arg(q->tableName()));
+                return false;
+            }
+            keys << key;
+        }
+    }
+
+    // one transaction for all batches, instead of one commit per row
+    QSqlDatabase db = database();
+    if(!db.transaction())
+    {
+        reportError("Begin transaction error " + db.lastError().text());
+        return false;
+    }
+
+    emit q->rowsAboutToBeWritten(keys);
+    for (int i = 0; i < keys.count(); i += BatchSize)
+    {
+        const QVariantList batch = keys.mid(i, BatchSize);
+        QStringList holders;
+        for (int n = 0; n < batch.count(); ++n)
+            holders << QStringLiteral("?");
+
+        if(!exec(statement.arg(holders.join(", ")), batch))
+        {
+            reportError(QString("Write rows of table '%1' error").arg(q->tableName()));
+            db.rollback();
+            return false;
+        }
+    }
+
+    if(!db.commit())
+    {
+        reportError("Commit error " + db.lastError().text());
+        db.rollback();
+        return false;
+    }
+
+    emit q->rowsWritten(keys);
+    return true;
+}
+
+int TableModelPrivate::removeRanges(const QVector<RowRange> &ranges)
+{
+    if(ranges.isEmpty())
+        return 0;
+
+    // rows in use go to the trash, rows removed from the trash are gone
+    const QString statement = softDelete() && !showDeleted
+            ? QString("UPDATE %1 SET %2 = datetime('now', 'localtime') WHERE %3 IN (%4)")
+              .arg(escapeTable(), escapeField("deleted_at"), keyField)
+            : QString("DELETE FROM %1 WHERE %2 IN (%3)").arg(escapeTable(), keyField);
+    if(!execByKeys(statement, ranges))
+        return 0;
+
+    int total = 0;
+    for (const RowRange &range : ranges)
+        total += range.second - range.first + 1;
+
+    takeRanges(ranges);
+    return total;
+}
+
+void TableModelPrivate::takeRanges(const QVector<RowRange> &ranges)
+{
+    Q_Q(TableModel);
+    if(fetchMode != TableModel::WindowedFetch)
+    {
+        // QSqlTableModel can not drop rows from its cache, read it once
+        q->QSqlRelationalTableModel::select();
+        return;
+    }
+
+    invalidatePages(source->pages.pageOf(ranges.first().first));
+    for (int i = ranges.count() - 1; i >= 0; --i)
+    {
+        const RowRange &range = ranges.at(i);
+        q->beginRemoveRows(QModelIndex(), range.first, range.second);
+        rowCount -= range.second - range.first + 1;
+        q->endRemoveRows();
+        source->removeRows(q, range.first, range.second);
+    }
+}
+
+int TableModelPrivate::recoverRanges(const QVector<RowRange> &ranges)
+{
+    Q_Q(TableModel);
+    if(ranges.isEmpty() || deletedAtColumn < 0)
+        return 0;
+
+    const QString statement = QString("UPDATE %1 SET %2 = NULL WHERE %3 IN (%4)")
+            .arg(escapeTable(), escapeField("deleted_at"), keyField);
+    if(!execByKeys(statement, ranges))
+        return 0;
+
+    int total = 0;
+    for (const RowRange &range : ranges)
+        total += range.second - range.first + 1;
+
+    // recovered rows leave the trash
+    if(showDeleted)
+    {
+        takeRanges(ranges);
+        return total;
+    }
+
+    if(fetchMode != TableModel::WindowedFetch)
+    {
+        q->QSqlRelationalTableModel::select();
+        return total;
+    }
+
+    for (const RowRange &range : ranges)
+    {
+        for (int row = range.first; row <= range.second; ++row)
+            source->pages.setValue(row, deletedAtColumn, QVariant());
+
+        emit q->dataChanged(q->index(range.first, 0),
+                            q->index(range.second, q->columnCount() - 1));
+        source->changeRows(q, range.first, range.second);
+    }
+
+    return total;
+}
+
+bool TableModelPrivate::readRow(const QVariant &key, QSqlRecord *record) const
+{
+    const QString statement = "SELECT " + selectFields() + " FROM " + escapeTable() + " WHERE " + keyField + " = ?";
+    const qint64 started = TableMetrics::now();
+    QSqlQuery query = Sql::prepare(statement, database());
+    query.addBindValue(key);
+
+    const bool ok = query.exec() && query.next();
+    metrics->addQuery(TableMetrics::ReadQuery, started, TableMetrics::now() - started, ok ? 1 : 0, statement);
+    if(!ok)
+    {
+        qWarning(lcTableModel) << "Read row error" << key << query.lastError().text();
+        return false;
+    }
+
+    *record = query.record();
+    query.finish();
+    return true;
+}
+
+void TableModelPrivate::patchRow(int row, const QSqlRecord &record)
+{
+    Q_Q(TableModel);
+    const QSqlRecord before = source->pages.record(row);
+    if(!source->pages.setRecord(row, record))
+        return;
+
+    // a page in flight was read before this write
+    ++source->serial;
+
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+    for (int field : lazyFields)
+        dropLazyValue(field, record.value(keyIndex).toString());
+
+    // only the cells whose value changed, e.g. also by a trigger
+    int first = -1;
+    int last = -1;
+    for (int column = 0; column < q->columnCount(); ++column)
+    {
+        const int field = fieldOf(column);
+        if(before.isEmpty() || lazyFields.contains(field)
+                || before.value(field) != record.value(field))
+        {
+            if(first < 0)
+                first = column;
+            last = column;
+        }
+    }
+
+    if(first >= 0)
+    {
+        emit q->dataChanged(q->index(row, first), q->index(row, last));
+        source->changeRows(q, row, row);
+    }
+}
+
+bool TableModelPrivate::queueEdit(int row, int column, const QVariant &value)
+{
+    Q_Q(TableModel);
+    const QVariant key = rowKey(row);
+    if(!key.isValid())
+        return false;
+
+    // one UPDATE per row, the last value of a cell wins
+    PendingEdit &edit = edits[key.toString()];
+    edit.key = key;
+    if(!edit.stored.contains(column))
+    {
+        QVariant stored;
+        source->pages.value(row, column, &stored);
+        edit.stored.insert(column, stored);
+    }
+    edit.values.insert(column, value);
+
+    source->pages.setValue(row, column, value);
+    dropLazyValue(column, key.toString());
+
+    // a page in flight was read before this edit
+    ++source->serial;
+    editStatus.insert(key.toString(), TableModel::PendingStatus);
+
+    emit q->dataChanged(q->index(row, 0), q->index(row, q->columnCount() - 1));
+    source->changeRows(q, row, row);
+
+    if(edits.count() >= WriteBehindRows)
+        flushEdits();
+    else if(!flushTimer.isActive() && !retryTimer.isActive())
+        flushTimer.start();
+
+    return true;
+}
+
+const QVariant *TableModelPrivate::pendingValue(const QString &key, int column) const
+{
+    for (const QMap<QString, PendingEdit> *queue : { &edits, &flushing })
+    {
+        QMap<QString, PendingEdit>::const_iterator edit = queue->constFind(key);
+        if(edit == queue->constEnd())
+            continue;
+
+        QMap<int, QVariant>::const_iterator value = edit->values.constFind(column);
+        if(value != edit->values.constEnd())
+            return &value.value();
+    }
+
+    return nullptr;
+}
+
+void TableModelPrivate::flushEdits(bool wait)
+{
+    Q_Q(TableModel);
+    flushTimer.stop();
+    retryTimer.stop();
+
+    if(wait)
+    {
+        // the transaction in flight ends first, its older values must not
+        // commit over the ones written here
+        if(!flushing.isEmpty() && pool)
+            QMetaObject::invokeMethod(pool->worker(0), []() {}, Qt::BlockingQueuedConnection);
+
+        // written on this connection before the table goes away, the rows
+        // of that transaction again, setting a value twice is harmless
+        for (QMap<QString, PendingEdit>::iterator it = edits.begin(); it != edits.end(); ++it)
+        {
+            PendingEdit &edit = flushing[it.key()];
+            edit.key = it->key;
+            for (QMap<int, QVariant>::const_iterator value = it->values.constBegin(); value != it->values.constEnd(); ++value)
+                edit.values.insert(value.key(), value.value());
+            for (QMap<int, QVariant>::const_iterator value = it->stored.constBegin(); value != it->stored.constEnd(); ++value)
+            {
+                if(!edit.stored.contains(value.key()))
+                    edit.stored.insert(value.key(), value.value());
+            }
+        }
+        edits.clear();
+
+        QStringList statements;
+        QVector<QVariantList> batch;
+        QVariantList keys;
+        for (const PendingEdit &edit : flushing)
+            keys << edit.key;
+        editStatements(&statements, &batch);
+        flushing.clear();
+        editStatus.clear();
+        if(statements.isEmpty())
+            return;
+
+        emit q->rowsAboutToBeWritten(keys);
+        QSqlDatabase db = database();
+        bool ok = db.transaction();
+        for (int i = 0; ok && i < statements.count(); ++i)
+            ok = exec(statements.at(i), batch.at(i));
+        if(ok && !db.commit())
+            ok = false;
+        if(!ok)
+        {
+            db.rollback();
+            reportError("Write pending edits error " + db.lastError().text());
+            return;
+        }
+
+        emit q->rowsWritten(keys);
+        return;
+    }
+
+    // one transaction at a time, edits queued meanwhile follow it
+    if(!flushing.isEmpty() || edits.isEmpty())
+        return;
+
+    flushing.swap(edits);
+
+    // the rows are as before until the transaction commits
+    QVariantList keys;
+    for (const PendingEdit &edit : flushing)
+        keys << edit.key;
+    emit q->rowsAboutToBeWritten(keys);
+
+    QueryTask task;
+    task.kind = QueryTask::Transaction;
+    task.databaseName = database().databaseName();
+    editStatements(&task.statements, &task.batch);
+    qDebug(lcTableModel) << "write" << flushing.count() << "edited rows";
+    task.owner = task.origin = owner;
+    worker()->post(task);
+}
+
+void TableModelPrivate::editStatements(QStringList *statements, QVector<QVariantList> *batch) const
+{
+    Q_Q(const TableModel);
+    for (const PendingEdit &edit : flushing)
+    {
+        QStringList fields;
+        QVariantList values;
+        for (QMap<int, QVariant>::const_iterator it = edit.values.constBegin(); it != edit.values.constEnd(); ++it)
+        {
+            fields << escapeField(q->record().fieldName(it.key())) + " = ?";
+            values << it.value();
+        }
+        values << edit.key;
+
+        *statements << QString("UPDATE %1 SET %2 WHERE %3 = ?").arg(escapeTable(), fields.join(", "), keyField);
+        *batch << values;
+    }
+}
+
+void TableModelPrivate::editsWritten(const QueryResult &result)
+{
+    Q_Q(TableModel);
+    QMap<QString, PendingEdit> written;
+    written.swap(flushing);
+
+    // written again by a synchronous flush meanwhile
+    if(written.isEmpty())
+        return;
+
+    if(result.ok)
+    {
+        writeFailures = 0;
+        RelationCache::invalidate(q->tableName());
+        QVariantList keys;
+        for (const PendingEdit &edit : written)
+            keys << edit.key;
+        emit q->rowsWritten(keys);
+    }
+    else
+    {
+        // kept for the next flush, edits made meanwhile win
+        reportError("Write pending edits error " + result.errorString);
+        for (QMap<QString, PendingEdit>::const_iterator it = written.constBegin(); it != written.constEnd(); ++it)
+        {
+            PendingEdit &edit = edits[it.key()];
+            edit.key = it->key;
+            for (QMap<int, QVariant>::const_iterator value = it->values.constBegin(); value != it->values.constEnd(); ++value)
+            {
+                if(!edit.values.contains(value.key()))
+                    edit.values.insert(value.key(), value.value());
+            }
+            for (QMap<int, QVariant>::const_iterator value = it->stored.constBegin(); value != it->stored.constEnd(); ++value)
+                edit.stored.insert(value.key(), value.value());
+        }
+    }
+
+    // the rows may have moved since the edit, they are found by key
+    const QHash<QString, int> rows = cachedRows();
+    for (QMap<QString, PendingEdit>::const_iterator it = written.constBegin(); it != written.constEnd(); ++it)
+    {
+        if(!result.ok)
+            editStatus.insert(it.key(), TableModel::ErrorStatus);
+        else if(!edits.contains(it.key()))
+            editStatus.remove(it.key());
+
+        const int row = rows.value(it.key(), -1);
+        if(row >= 0 && row < rowCount)
+            emit q->dataChanged(q->index(row, 0), q->index(row, q->columnCount() - 1),
+                                QVector<int>() << StatusRole);
+    }
+
+    if(result.ok && !edits.isEmpty())
+    {
+        flushTimer.start();
+    }
+    else if(!result.ok)
+    {
+        // tried again after twice the wait of the last failure
+        ++writeFailures;
+        retryTimer.start(int(qMin<qint64>(MaxRetryInterval,
+                                          qint64(qMax(1, flushTimer.interval())) << qMin(writeFailures, 16))));
+    }
+}
+
+QHash<QString, int> TableModelPrivate::cachedRows() const
+{
+    Q_Q(const TableModel);
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+    QHash<QString, int> rows;
+    for (int page : source->pages.pages())
+    {
+        const QVariantList keys = source->pages.column(page, keyIndex);
+        const int first = source->pages.firstRow(page);
+        for (int i = 0; i < keys.count(); ++i)
+            rows.insert(keys.at(i).toString(), first + i);
+    }
+
+    return rows;
+}
+
+int TableModelPrivate::itemStatus(int row) const
+{
+    Q_Q(const TableModel);
+    if(!editStatus.isEmpty())
+    {
+        const QVariant key = keyOf(row);
+        QHash<QString, int>::const_iterator status = editStatus.constFind(key.toString());
+        if(key.isValid() && status != editStatus.constEnd())
+            return status.value();
+    }
+
+    if(stateColumn < 0)
+        return TableModel::SavedStatus;
+
+    const QVariant state = fetchMode == TableModel::WindowedFetch
+            ? windowValue(row, stateColumn)
+            : q->QSqlRelationalTableModel::data(q->index(row, stateColumn), Qt::EditRole);
+    return state.isNull() ? int(TableModel::SavedStatus) : state.toInt();
+}
+
+void TableModelPrivate::reportError(const QString &message)
+{
+    Q_Q(TableModel);
+    qWarning(lcTableModel) << message;
+    errorString = message;
+    emit q->error(message);
+}
+
+void TableModelPrivate::setProfile(const SqlProfile &profile)
+{
+    Q_Q(TableModel);
+    Sql::setProfile(profile);
+
+    // applied to the connection of this model now, the pooled ones on
+    // their next use
+    Sql::applyProfile(q->database(), profile);
+    emit q->profileChanged();
+}
+
+void TableModelPrivate::updateProjection()
+{
+    Q_Q(TableModel);
+    projection.clear();
+    lazyFields.clear();
+    clearLazyValues();
+    if(fetchMode != TableModel::WindowedFetch || columns.isEmpty())
+        return;
+
+    const QSqlRecord record = q->record();
+    for (const QString &name : columns)
+    {
+        const int field = record.indexOf(name.trimmed());
+        if(field >= 0 && !projection.contains(field))
+            projection << field;
+        else if(field < 0)
+            qWarning(lcTableModel) << "Unknown column" << name << "in" << q->tableName();
+    }
+
+    // TEXT and BLOB values may be large, VARCHAR(n) and numbers are not
+    const SchemaCache::Table table = SchemaCache::table(database(), q->tableName());
+    for (QHash<QString, QString>::const_iterator it = table.types.constBegin(); it != table.types.constEnd(); ++it)
+    {
+        const QString &type = it.value();
+        const int field = record.indexOf(it.key());
+        if(projection.contains(field) && field != keyColumn
+                && (type.contains("TEXT") || type.contains("BLOB") || type.contains("CLOB")))
+            lazyFields.insert(field);
+    }
+}
+
+void TableModelPrivate::updateRoles()
+{
+    Q_Q(TableModel);
+    roles.clear();
+    updateProjection();
+
+    // for checked
+    roles.insert(Qt::CheckStateRole, QByteArrayLiteral("checkState"));
+
+    // table view delegates bind the cell of their own column
+    roles.insert(Qt::DisplayRole, QByteArrayLiteral("display"));
+    roles.insert(StatusRole, QByteArrayLiteral("itemStatus"));
+
+    // database table fileds
+    const QSqlRecord record = q->record();
+    roleFields = record.count();
+    for (int i = 0; i < record.count(); ++i)
+    {
+        // the roles of a projection are its fields only
+        if(projection.isEmpty() || projection.contains(i))
+            roles.insert(Qt::UserRole + 1 + i, record.fieldName(i).toUtf8());
+    }
+
+    deletedAtColumn = record.indexOf("deleted_at");
+    stateColumn = record.indexOf("state");
+    resetGeometry();
+}
+
+void TableModelPrivate::resetGeometry()
+{
+    Q_Q(TableModel);
+    QStringList headers;
+    for (int column = 0; column < q->columnCount(); ++column)
+        headers << q->headerData(column, Qt::Horizontal).toString();
+
+    measuredPages.clear();
+    geometry->setHeaders(headers);
+}
+
+void TableModelPrivate::measurePage(int page) const
+{
+    Q_Q(const TableModel);
+    if(!geometry->autoSize() || measuredPages.contains(page) || !source->pages.contains(page))
+        return;
+
+    // rows spread over the page, the values as shown by data()
+    measuredPages.insert(page);
+    const int first = source->pages.firstRow(page);
+    const int step = qMax(1, source->pages.pageSize() / SampleRows);
+    const int columns = q->columnCount();
+    for (int row = first; row < first + source->pages.pageSize(); row += step)
+    {
+        const QSqlRecord record = source->pages.record(row);
+        if(record.isEmpty())
+            break;
+
+        for (int column = 0; column < columns; ++column)
+        {
+            // large values are not in the page, the header gives the width
+            const int field = fieldOf(column);
+            if(!lazyFields.contains(field) && geometry->canWiden(column))
+                geometry->measure(column, displayValue(field, record.value(field)).toString());
+        }
+    }
+    geometry->updateWidths();
+}
+
+void TableModelPrivate::measureRows(int first, int last)
+{
+    Q_Q(TableModel);
+    if(!geometry->autoSize() || fetchMode != TableModel::CachedFetch || last < first)
+        return;
+
+    const int step = qMax(1, (last - first + 1) / SampleRows);
+    const int columns = q->columnCount();
+    for (int row = first; row <= last; row += step)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            if(!geometry->canWiden(column))
+                continue;
+
+            const QModelIndex index = q->index(row, column);
+            geometry->measure(column, displayValue(column, q->QSqlRelationalTableModel::data(index)).toString());
+        }
+    }
+    geometry->updateWidths();
+}
+
+void TableModelPrivate::selectionChanged(int first, int last)
+{
+    Q_Q(TableModel);
+    emit q->selectedRowsChanged();
+    emit q->dataChanged(q->index(first, 0), q->index(last, q->columnCount() - 1),
+                        QVector<int>() << Qt::CheckStateRole);
+}
+
+void TableModelPrivate::saveSelection()
+{
+    Q_Q(TableModel);
+    // a reset before the restore keeps the keys of the first
+    if(restoreQueued || selection.isEmpty())
+        return;
+
+    // windowed rows are reset by a new select only, writes patch them
+    if(fetchMode != TableModel::CachedFetch || keyColumn < 0)
+        return;
+
+    selectedFetched = q->rowCount();
+    selectedAll = selection.count() == selectedFetched;
+    if(!selectedAll)
+    {
+        for (const RowRange &range : selection.ranges())
+        {
+            for (int row = range.first; row <= range.second; ++row)
+                selectedKeys.insert(keyOf(row).toString());
+        }
+    }
+
+    restoreQueued = true;
+    QMetaObject::invokeMethod(q, [this]() {
+        restoreSelection();
+    }, Qt::QueuedConnection);
+}
+
+void TableModelPrivate::restoreSelection()
+{
+    Q_Q(TableModel);
+    restoreQueued = false;
+    if(fetchMode != TableModel::CachedFetch)
+    {
+        selectedKeys.clear();
+        selectedAll = false;
+        emit q->selectedRowsChanged();
+        return;
+    }
+
+    // the rows fetched before the reset, where the selected rows were
+    while (q->rowCount() < selectedFetched && q->canFetchMore())
+        q->fetchMore();
+
+    const int rows = q->rowCount();
+    if(selectedAll && rows > 0)
+    {
+        selection.select(0, rows - 1);
+    }
+    else
+    {
+        for (int row = 0; row < rows && !selectedKeys.isEmpty(); ++row)
+        {
+            if(selectedKeys.remove(keyOf(row).toString()))
+                selection.select(row, row);
+        }
+    }
+
+    selectedKeys.clear();
+    selectedAll = false;
+    emit q->selectedRowsChanged();
+    if(!selection.isEmpty())
+        emit q->dataChanged(q->index(selection.ranges().first().first, 0),
+                            q->index(selection.ranges().last().second, q->columnCount() - 1),
+                            QVector<int>() << Qt::CheckStateRole);
+}
+
+void TableModelPrivate::updateFeed()
+{
+    Q_Q(TableModel);
+    const bool live = liveSync && completed && !readOnly;
+    const QString name = database().databaseName();
+    if(feed && live && feed->databaseName() == name && feedTable == q->tableName())
+        return;
+
+    if(feed)
+    {
+        QObject::disconnect(feed.data(), nullptr, q, nullptr);
+        feed->untrack(feedTable);
+    }
+    feed.reset();
+    feedTable.clear();
+    if(!live)
+        return;
+
+    feed = ChangeFeed::acquire(name);
+    if(!feed->isValid())
+    {
+        reportError("No change log for the live sync of " + name + ", see 005_changes.sql");
+        return;
+    }
+
+    // the table is logged while it is followed
+    feedTable = q->tableName();
+    feed->track(feedTable, keyColumn >= 0 ? q->record().fieldName(keyColumn) : QStringLiteral("rowid"));
+
+    QObject::connect(feed.data(), &ChangeFeed::changed, q,
+                     [this](const QString &table, const ChangeFeed::ChangeSet &changes, qint64 seq) {
+        if(table == q_ptr->tableName().toLower())
+            applyChanges(changes, seq);
+    });
+    QObject::connect(feed.data(), &ChangeFeed::overflowed, q, [this]() {
+        refreshLater();
+    });
+}
+
+void TableModelPrivate::applyChanges(const ChangeFeed::ChangeSet &logged, qint64 seq)
+{
+    Q_Q(TableModel);
+    // the views of a shared source see the change applied by one of them
+    if(fetchMode == TableModel::WindowedFetch)
+    {
+        if(seq <= source->syncedSeq)
+            return;
+        source->syncedSeq = seq;
+    }
+
+    // the writes of the views are applied already
+    ChangeFeed::ChangeSet changes = logged;
+    changes.inserted.subtract(source->written);
+    changes.updated.subtract(source->written);
+    changes.deleted.subtract(source->written);
+    source->written.clear();
+    if(changes.inserted.isEmpty() && changes.updated.isEmpty() && changes.deleted.isEmpty())
+        return;
+
+    // QSqlTableModel can not patch its rows, they are selected again
+    // unless edits are held
+    if(fetchMode != TableModel::WindowedFetch)
+    {
+        if(!q->isDirty())
+            refreshLater();
+        return;
+    }
+
+    // the cached rows by key, rows past the last one are ordered after all
+    // of them when the order is by key
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+    QHash<qint64, int> cached;
+    qint64 lastKey = std::numeric_limits<qint64>::min();
+    int lastPage = -1;
+    for (int page : source->pages.pages())
+    {
+        const QVariantList keys = source->pages.column(page, keyIndex);
+        const int first = source->pages.firstRow(page);
+        for (int i = 0; i < keys.count(); ++i)
+        {
+            const qint64 key = keys.at(i).toLongLong();
+            cached.insert(key, first + i);
+            lastKey = qMax(lastKey, key);
+        }
+        lastPage = qMax(lastPage, page);
+    }
+
+    const bool keyOrder = searchQuery.isEmpty() && sortField().isEmpty();
+    const bool filtered = !searchQuery.isEmpty() || !whereClause().isEmpty();
+    bool unknown = false;   // rows moved where the cache can not follow
+    bool recount = false;   // rows came or went behind the cache
+    QVector<int> removed;
+    QHash<qint64, int> updated;
+
+    for (qint64 key : changes.deleted)
+    {
+        if(cached.contains(key))
+            removed << cached.value(key);
+        else if(keyOrder && key > lastKey)
+            recount = true;
+        else
+            unknown = true;
+    }
+
+    for (qint64 key : changes.inserted)
+    {
+        if(keyOrder && key > lastKey)
+            recount = true;
+        else
+            unknown = true;
+    }
+
+    for (qint64 key : changes.updated)
+    {
+        // edits not written yet stay over the rows read
+        if(cached.contains(key) && !edits.contains(QString::number(key))
+                && !flushing.contains(QString::number(key)))
+            updated.insert(key, cached.value(key));
+        else if(cached.contains(key) || (!filtered && sortField().isEmpty()))
+            continue;
+        else if(keyOrder && key > lastKey)
+            recount = true;
+        else
+            unknown = true;
+    }
+
+    if(!unknown && !updated.isEmpty())
+        unknown = !rereadRows(updated, &removed);
+
+    if(unknown)
+    {
+        // the views read the pages they show again
+        invalidatePages(0);
+        if(rowCount > 0)
+        {
+            emit q->dataChanged(q->index(0, 0), q->index(rowCount - 1, q->columnCount() - 1));
+            source->changeRows(q, 0, rowCount - 1);
+        }
+        recount = true;
+    }
+    else if(!removed.isEmpty())
+    {
+        std::sort(removed.begin(), removed.end());
+        QVector<RowRange> ranges;
+        for (int row : removed)
+        {
+            if(!ranges.isEmpty() && ranges.last().second + 1 == row)
+                ranges.last().second = row;
+            else if(ranges.isEmpty() || ranges.last().second != row)
+                ranges << qMakePair(row, row);
+        }
+        takeRanges(ranges);
+    }
+    else if(recount)
+    {
+        // the anchors behind the cache are off by the rows that came
+        invalidatePages(lastPage + 1);
+    }
+
+    if(recount)
+    {
+        QueryTask count;
+        count.kind = QueryTask::Count;
+        count.statement = countStatement(&count.values);
+        post(count);
+    }
+}
+
+bool TableModelPrivate::rereadRows(const QHash<qint64, int> &rows, QVector<int> *removed)
+{
+    Q_Q(TableModel);
+    // a ranked row may move with any change
+    if(!searchQuery.isEmpty())
+        return false;
+
+    const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+    const int sortField = sortIndex();
+    const QString where = whereClause();
+    const QList<qint64> keys = rows.keys();
+    QSet<qint64> found;
+    for (int i = 0; i < keys.count(); i += BatchSize)
+    {
+        QStringList holders;
+        QVariantList values;
+        for (qint64 key : keys.mid(i, BatchSize))
+        {
+            holders << QStringLiteral("?");
+            values << key;
+        }
+
+        // index lookups of the cached rows only, a row that fails the
+        // filter now has left the view
+        const QString statement = "SELECT " + selectFields() + " FROM " + escapeTable() + " WHERE "
+                + (where.isEmpty() ? QString() : where + " AND ") + keyField + " IN (" + holders.join(", ") + ")";
+        const qint64 started = TableMetrics::now();
+        QSqlQuery query = Sql::prepare(statement, database());
+        for (const QVariant &value : values)
+            query.addBindValue(value);
+
+        if(!query.exec())
+        {
+            qWarning(lcTableModel) << "Read changed rows error" << query.lastError().text();
+            return false;
+        }
+
+        int read = 0;
+        while (query.next())
+        {
+            const QSqlRecord record = query.record();
+            const qint64 key = record.value(keyIndex).toLongLong();
+            const int row = rows.value(key, -1);
+            if(row < 0)
+                continue;
+
+            // a new sort value moves the row
+            if(sortField >= 0 && source->pages.record(row).value(sortField) != record.value(sortField))
+                return false;
+
+            found.insert(key);
+            patchRow(row, record);
+            ++read;
+        }
+        query.finish();
+        metrics->addQuery(TableMetrics::ReadQuery, started, TableMetrics::now() - started, read, statement);
+    }
+
+    for (QHash<qint64, int>::const_iterator it = rows.constBegin(); it != rows.constEnd(); ++it)
+    {
+        if(!found.contains(it.key()))
+            *removed << it.value();
+    }
+
+    return true;
+}
+
+QueryWorker *TableModelPrivate::worker() const
+{
+    // in order with the counts and pages of the sources of the database
+    const QString name = database().databaseName();
+    if(!pool || pool->databaseName() != name)
+    {
+        if(pool)
+            QObject::disconnect(pool.data(), nullptr, q_ptr, nullptr);
+        pool = QueryPool::acquire(name);
+        QObject::connect(pool.data(), &QueryPool::finished, q_ptr, [this](const QueryResult &result) {
+            if(result.owner == owner)
+                q_ptr->d_func()->onQueryFinished(result);
+        });
+    }
+
+    return pool->worker(0);
+}
+
+QString TableModelPrivate::sourceKey() const
+{
+    Q_Q(const TableModel);
+    if(!completed || fetchMode != TableModel::WindowedFetch || q->tableName().isEmpty())
+        return QString();
+
+    // the parts of the page statement, models alike read the same rows
+    QVariantList values;
+    QStringList parts;
+    parts << database().databaseName() << selectFields() << fromClause(&values)
+          << whereClause() << orderBy() << QString::number(pageSize);
+    for (const QVariant &value : values)
+        parts << value.toString();
+
+    return parts.join(QChar(0x1f));
+}
+
+bool TableModelPrivate::attachSource()
+{
+    Q_Q(TableModel);
+    const QString key = sourceKey();
+
+    // a refresh of the rows shown reads them again for all views
+    if(source && source->isShared() && source->key() == key)
+    {
+        source->reset(q);
+        return false;
+    }
+
+    setSource(DataSource::acquire(key, pageSize, cachedPages));
+
+    // pages of an immutable file are read side by side
+    source->setReaders(readOnly ? qBound(1, QThread::idealThreadCount(), MaxReaders) : 1);
+    return source->count >= 0 || source->counting;
+}
+
+void TableModelPrivate::detachSource()
+{
+    setSource(DataSource::acquire(QString(), pageSize, cachedPages));
+}
+
+void TableModelPrivate::setSource(const QSharedPointer<DataSource> &shared)
+{
+    Q_Q(TableModel);
+    if(source == shared)
+        return;
+
+    if(source)
+        QObject::disconnect(source.data(), nullptr, q, nullptr);
+
+    source = shared;
+    QObject::connect(source.data(), &DataSource::finished, q, [this](const QueryResult &result) {
+        onQueryFinished(result);
+    });
+    QObject::connect(source.data(), &DataSource::pageStored, q, [this](int page, const QVector<QSqlRecord> &rows) {
+        pageStored(page, rows);
+    });
+    QObject::connect(source.data(), &DataSource::counted, q, [this](int count) {
+        sourceCounted(count);
+    });
+    QObject::connect(source.data(), &DataSource::wasReset, q, [this](QObject *origin) {
+        sourceReset(origin);
+    });
+    QObject::connect(source.data(), &DataSource::rowsChanged, q, [this](QObject *origin, int first, int last) {
+        sourceRowsChanged(origin, first, last);
+    });
+    QObject::connect(source.data(), &DataSource::rowsRemoved, q, [this](QObject *origin, int first, int last) {
+        sourceRowsRemoved(origin, first, last);
+    });
+    QObject::connect(source.data(), &DataSource::rowsInserted, q, [this](QObject *origin, int first, int last) {
+        sourceRowsInserted(origin, first, last);
+    });
+}
+
+void TableModelPrivate::sourceCounted(int count)
+{
+    Q_Q(TableModel);
+    if(fetchMode != TableModel::WindowedFetch)
+        return;
+
+    // the rows not delivered by a page yet, or past the estimate, arrive
+    // as one batch
+    setCountKnown(true);
+    if(count > rowCount)
+    {
+        q->beginInsertRows(QModelIndex(), rowCount, count - 1);
+        rowCount = count;
+        q->endInsertRows();
+    }
+    else if(count < rowCount)
+    {
+        q->beginRemoveRows(QModelIndex(), count, rowCount - 1);
+        rowCount = count;
+        q->endRemoveRows();
+    }
+}
+
+void TableModelPrivate::sourceReset(QObject *origin)
+{
+    Q_Q(TableModel);
+    if(origin == q)
+        return;
+
+    // counted and paged again by the model that refreshed
+    q->beginResetModel();
+    clearLazyValues();
+    setCountKnown(false);
+    rowCount = 0;
+    q->endResetModel();
+}
+
+void TableModelPrivate::sourceRowsChanged(QObject *origin, int first, int last)
+{
+    Q_Q(TableModel);
+    last = qMin(last, rowCount - 1);
+    if(origin == q || first > last)
+        return;
+
+    // large values of the rows are read again
+    if(!lazyFields.isEmpty())
+    {
+        const int keyIndex = keyColumn < 0 ? q->record().count() : keyColumn;
+        for (int row = first; row <= last; ++row)
+        {
+            const QString key = source->pages.record(row).value(keyIndex).toString();
+            for (int field : lazyFields)
+                dropLazyValue(field, key);
+        }
+    }
+
+    emit q->dataChanged(q->index(first, 0), q->index(last, q->columnCount() - 1));
+}
+
+void TableModelPrivate::sourceRowsRemoved(QObject *origin, int first, int last)
+{
+    Q_Q(TableModel);
+    last = qMin(last, rowCount - 1);
+    if(origin == q || first > last)
+        return;
+
+    q->beginRemoveRows(QModelIndex(), first, last);
+    rowCount -= last - first + 1;
+    q->endRemoveRows();
+}
+
+void TableModelPrivate::sourceRowsInserted(QObject *origin, int first, int last)
+{
+    Q_Q(TableModel);
+    // rows past the end are seen by a page or the count later
+    if(origin == q || !countKnown || first != rowCount)
+        return;
+
+    q->beginInsertRows(QModelIndex(), first, last);
+    rowCount += last - first + 1;
+    q->endInsertRows();
+}
+
+void TableModelPrivate::post(QueryTask task) const
+{
+    task.databaseName = database().databaseName();
+    task.origin = owner;
+    source->post(task);
+
+    // may be called from data(), notify once back in the event loop
+    QMetaObject::invokeMethod(q_ptr, [this]() {
+        q_ptr->d_func()->updateLoading();
+    }, Qt::QueuedConnection);
+}
+
+void TableModelPrivate::requestPage(int page) const
+{
+    if(source->pendingPages.contains(page))
+        return;
+
+    QueryTask task;
+    task.kind = QueryTask::Page;
+    task.page = page;
+    task.statement = pageStatement(page, &task.values);
+    post(task);
+}
+
+void TableModelPrivate::onQueryFinished(const QueryResult &result)
+{
+    Q_Q(TableModel);
+    static const TableMetrics::QueryType types[] = {
+        TableMetrics::CountQuery, TableMetrics::PageQuery,
+        TableMetrics::ExecQuery, TableMetrics::TransactionQuery,
+        TableMetrics::ReadQuery, TableMetrics::CountQuery
+    };
+    // a result of the source is counted and reported by the model that
+    // asked for it only
+    const bool own = result.origin == owner;
+    if(own)
+        metrics->addQuery(types[result.kind], result.started, result.elapsed,
+                          result.rows.count(), result.statement, true);
+
+    // written edits are no part of a select, the results of a select come
+    // from the source, of its current generation only
+    if(result.kind == QueryTask::Transaction)
+    {
+        editsWritten(result);
+        return;
+    }
+
+    if(result.kind == QueryTask::Read)
+    {
+        lazyRead(result);
+        return;
+    }
+
+    if(result.kind == QueryTask::Exec && indexing.contains(result.statement))
+    {
+        indexCreated(result.statement, result.ok, result.errorString);
+        return;
+    }
+
+    // a failed estimate leaves the rows to the count
+    if(result.kind == QueryTask::Estimate)
+    {
+        if(!countKnown && source->estimate > rowCount)
+        {
+            q->beginInsertRows(QModelIndex(), rowCount, source->estimate - 1);
+            rowCount = source->estimate;
+            q->endInsertRows();
+        }
+        updateLoading();
+        return;
+    }
+
+    if(!result.ok)
+    {
+        if(own)
+            reportError("Read record error " + result.errorString);
+        updateLoading();
+        return;
+    }
+
+    // the count arrives by sourceCounted()
+    if(result.kind == QueryTask::Page)
+    {
+        if(result.serial != source->serial)
+        {
+            // the cache changed while the page was in flight, read it again
+            if(!source->pages.contains(result.page))
+                requestPage(result.page);
+        }
+        else if(!result.rows.isEmpty())
+        {
+            const int first = source->pages.firstRow(result.page);
+            const int last = first + result.rows.count() - 1;
+            if(!countKnown && source->estimate < 0 && last >= rowCount)
+            {
+                q->beginInsertRows(QModelIndex(), rowCount, last);
+                rowCount = last + 1;
+                q->endInsertRows();
+            }
+
+            if(first < rowCount)
+                emit q->dataChanged(q->index(first, 0),
+                                    q->index(qMin(last, rowCount - 1), q->columnCount() - 1));
+        }
+    }
+
+    updateLoading();
+}
+
+void TableModelPrivate::updateLoading()
+{
+    Q_Q(TableModel);
+    const bool busy = source->tasksDone < source->tasksIssued;
+    if(!busy)
+        source->tasksIssued = source->tasksDone = 0;
+
+    emit q->progressChanged();
+    if(busy != loading)
+    {
+        loading = busy;
+        emit q->loadingChanged();
+    }
+}
+
+
+TableModel::TableModel(QObject *parent)
+    : QSqlRelationalTableModel(parent, Sql::takeConnection())
+    , d_ptr(new TableModelPrivate())
+{
+    Q_D(TableModel);
+    d->q_ptr = this;
+
+    setEditStrategy(OnFieldChange);
+
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(500);
+    connect(&d->flushTimer, &QTimer::timeout, this, [d]() {
+        d->flushEdits();
+    });
+    d->retryTimer.setSingleShot(true);
+    connect(&d->retryTimer, &QTimer::timeout, this, [d]() {
+        d->flushEdits();
+    });
+
+    d->swapTimer.setSingleShot(true);
+    d->swapTimer.setInterval(SwapTimeout);
+    connect(&d->swapTimer, &QTimer::timeout, this, [d]() {
+        d->finishPrefetch();
+    });
+
+    d->metrics = new TableMetrics(this);
+    d->geometry = new ColumnGeometry(this);
+    d->detachSource();
+    d->horizontalHeader = new HeaderModel(this, Qt::Horizontal, this);
+    d->verticalHeader = new HeaderModel(this, Qt::Vertical, this);
+
+    // the own writes come back by the feed, they are skipped there
+    connect(this, &TableModel::rowsWritten, this, [d](const QVariantList &keys) {
+        if(d->feed)
+        {
+            for (const QVariant &key : keys)
+                d->source->written.insert(key.toLongLong());
+        }
+    });
+    // selected rows follow the rows of the model
+    connect(this, &QAbstractItemModel::rowsInserted, this, [d](const QModelIndex &parent, int first, int last) {
+        if(!parent.isValid())
+            d->selection.insertRows(first, last - first + 1);
+    });
+    connect(this, &QAbstractItemModel::rowsRemoved, this, [this, d](const QModelIndex &parent, int first, int last) {
+        const int count = d->selection.count();
+        if(!parent.isValid())
+            d->selection.removeRows(first, last);
+        if(count != d->selection.count())
+            emit selectedRowsChanged();
+    });
+    // column widths sampled from the rows read
+    connect(this, &QAbstractItemModel::rowsInserted, this, [d](const QModelIndex &parent, int first, int last) {
+        if(!parent.isValid())
+            d->measureRows(first, last);
+    });
+    connect(this, &QAbstractItemModel::modelReset, this, [this, d]() {
+        d->measureRows(0, qMin(rowCount(), SampleRows) - 1);
+    });
+    connect(d->geometry, &ColumnGeometry::remeasure, this, [this, d]() {
+        const QSet<int> measured = d->measuredPages;
+        d->measuredPages.clear();
+        for (int page : measured)
+            d->measurePage(page);
+        d->measureRows(0, qMin(rowCount(), SampleRows) - 1);
+    });
+    // the selected keys are looked up in the new rows
+    connect(this, &QAbstractItemModel::modelAboutToBeReset, this, [d]() {
+        d->saveSelection();
+    });
+    connect(this, &QAbstractItemModel::modelReset, this, [this, d]() {
+        if(d->selection.isEmpty())
+            return;
+        d->selection.clear();
+        if(!d->restoreQueued)
+            emit selectedRowsChanged();
+    });
+}
+
+TableModel::~TableModel()
+{
+    Q_D(TableModel);
+    d->flushEdits(true);
+    if(d->feed)
+        d->feed->untrack(d->feedTable);
+
+    delete d->prefetcher;
+
+    // a running import or export is canceled and joined
+    delete d->importer;
+    delete d->exporter;
+
+    // closed with its statements, the next model of this thread takes
+    // the connection over
+    Sql::releaseConnection(database());
+}
+
+void TableModel::classBegin()
+{
+    qDebug(lcTableModel) << "TableModel::classBegin";
+}
+
+void TableModel::componentComplete()
+{
+    Q_D(TableModel);
+    qDebug(lcTableModel) << "TableModel::componentComplete";
+
+    // connect signals slot
+
+    if(d->databaseName.isEmpty() && d->tableName.isEmpty())
+    {
+        // use default database and table
+        Sql::memoryDatabase();
+        d->databaseName = ":memory:";
+        d->tableName = "books";
+    }
+
+    d->open(d->databaseName);
+    this->setTable(d->tableName);
+
+    qDebug() << "database:" << d->database().databaseName()
+             << ", table:"  << this->tableName();
+
+    d->completed = true;
+    this->select();
+    d->updateFeed();
+}
+
+Qt::ItemFlags TableModel::flags(const QModelIndex &index) const
+{
+    Q_D(const TableModel);
+    const Qt::ItemFlags flags = QSqlRelationalTableModel::flags(index);
+    return d->readOnly ? flags & ~Qt::ItemIsEditable : flags;
+}
+
+QHash<int, QByteArray> TableModel::roleNames() const
+{
+    Q_D(const TableModel);
+    return d->roles;
+}
+
+bool TableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    Q_D(TableModel);
+    if(!index.isValid())
+        return false;
+
+    if(role < Qt::UserRole)
+    {
+        if(role == Qt::CheckStateRole)
+        {
+            if(value.toBool())
+                d->selection.select(index.row(), index.row());
+            else
+                d->selection.deselect(index.row(), index.row());
+
+            d->selectionChanged(index.row(), index.row());
+            return true;
+        }
+
+        if(!d->writable("edit"))
+            return false;
+
+        if(d->fetchMode != WindowedFetch)
+        {
+            const bool ok = QSqlRelationalTableModel::setData(index, value, role);
+            if(ok)
+            {
+                RelationCache::invalidate(this->tableName());
+                emit rowsWritten(QVariantList());
+            }
+            return ok;
+        }
+
+        role = Qt::UserRole + 1 + d->fieldOf(index.column());
+    }
+
+    const int column = d->roleColumn(role);
+    if(column < 0 || !d->writable("edit"))
+        return false;
+
+    if(d->fetchMode == WindowedFetch && d->writeBehind)
+        return d->queueEdit(index.row(), column, value);
+
+    if(d->fetchMode == WindowedFetch)
+    {
+        const QVariant key = d->rowKey(index.row());
+        const QString statement = QString("UPDATE %1 SET %2 = ? WHERE %3 = ?")
+                .arg(d->escapeTable(), d->escapeField(record().fieldName(column)), d->keyField);
+        if(!key.isValid())
+            return false;
+
+        emit rowsAboutToBeWritten(QVariantList() << key);
+        if(!d->exec(statement, QVariantList() << value << key))
+            return false;
+        emit rowsWritten(QVariantList() << key);
+
+        // read back only the written row instead of selecting again
+        QSqlRecord record;
+        if(d->readRow(key, &record))
+        {
+            d->patchRow(index.row(), record);
+        }
+        else
+        {
+            d->dropPage(d->source->pages.pageOf(index.row()));
+            emit dataChanged(this->index(index.row(), 0), this->index(index.row(), columnCount() - 1));
+            d->source->changeRows(this, index.row(), index.row());
+        }
+        return true;
+    }
+
+    const QModelIndex modelIndex = column == index.column() ? index : createIndex(index.row(), column);
+    const bool ok = QSqlRelationalTableModel::setData(modelIndex, value, Qt::EditRole);
+    if(ok)
+    {
+        RelationCache::invalidate(this->tableName());
+        emit rowsWritten(QVariantList());
+    }
+    return ok;
+}
+
+QVariant TableModel::data(const QModelIndex &index, int role) const
+{
+    Q_D(const TableModel);
+    if (!index.isValid())
+        return QVariant();
+
+    d->metrics->countData();
+    if(role == StatusRole)
+        return d->itemStatus(index.row());
+
+    if(role < Qt::UserRole)
+    {
+        if(role == Qt::CheckStateRole)
+            return d->selection.contains(index.row());
+
+        if(d->fetchMode == WindowedFetch)
+        {
+            if(role != Qt::DisplayRole && role != Qt::EditRole)
+                return QVariant();
+
+            const int field = d->fieldOf(index.column());
+            const QVariant value = d->windowValue(index.row(), field);
+            return role == Qt::DisplayRole ? d->displayValue(field, value) : value;
+        }
+
+        if(role == Qt::DisplayRole && !d->relations.isEmpty())
+            return d->displayValue(index.column(), QSqlRelationalTableModel::data(index, role));
+
+        return QSqlRelationalTableModel::data(index, role);
+    }
+
+    const int column = d->roleColumn(role);
+    if(column < 0)
+        return QVariant();
+
+    // read the page record directly
+    if(d->fetchMode == WindowedFetch)
+        return d->displayValue(column, d->windowValue(index.row(), column));
+
+    const QModelIndex modelIndex = column == index.column() ? index : createIndex(index.row(), column);
+    return d->displayValue(column, QSqlRelationalTableModel::data(modelIndex, Qt::DisplayRole));
+}
+
+QVariant TableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    Q_D(const TableModel);
+    if(d->fetchMode != WindowedFetch || role != Qt::DisplayRole)
+        return QSqlRelationalTableModel::headerData(section, orientation, role);
+
+    if(orientation == Qt::Vertical)
+        return section + 1;
+
+    return record().fieldName(d->fieldOf(section));
+}
+
+int TableModel::columnCount(const QModelIndex &parent) const
+{
+    Q_D(const TableModel);
+    if(d->fetchMode != WindowedFetch)
+        return QSqlRelationalTableModel::columnCount(parent);
+
+    if(parent.isValid())
+        return 0;
+
+    return d->projection.isEmpty() ? record().count() : d->projection.count();
+}
+
+int TableModel::rowCount(const QModelIndex &parent) const
+{
+    Q_D(const TableModel);
+    if(d->fetchMode == WindowedFetch)
+        return parent.isValid() ? 0 : d->rowCount;
+
+    return QSqlRelationalTableModel::rowCount(parent);
+}
+
+bool TableModel::canFetchMore(const QModelIndex &parent) const
+{
+    Q_D(const TableModel);
+    // every row is reachable already, pages are loaded on demand
+    if(d->fetchMode == WindowedFetch)
+        return false;
+
+    return QSqlRelationalTableModel::canFetchMore(parent);
+}
+
+bool TableModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    Q_D(TableModel);
+    if(parent.isValid() || row < 0 || count <= 0 || row + count > rowCount())
+        return false;
+
+    if(!d->writable("remove rows"))
+        return false;
+
+    // windowed and soft deleted rows are removed by their keys
+    const RowRange range = qMakePair(row, row + count - 1);
+    if(d->fetchMode == WindowedFetch || (d->softDelete() && d->canBatch()))
+        return d->removeRanges(QVector<RowRange>() << range) > 0;
+
+    if(d->softDelete() && !d->showDeleted)
+    {
+        // no single key column, QSqlTableModel updates by all the values;
+        // held until all rows are set, a submit per field would select
+        // again and move the rows not set yet
+        const QVariant now = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+        const EditStrategy strategy = editStrategy();
+        QSqlRelationalTableModel::setEditStrategy(OnManualSubmit);
+        bool ok = true;
+        for (int i = row; i < row + count && ok; ++i)
+            ok = QSqlRelationalTableModel::setData(index(i, d->deletedAtColumn), now, Qt::EditRole);
+        ok = ok && QSqlRelationalTableModel::submitAll();
+        if(!ok)
+            d->reportError("Remove rows error " + this->lastError().text());
+        QSqlRelationalTableModel::setEditStrategy(strategy);
+
+        RelationCache::invalidate(this->tableName());
+        QSqlRelationalTableModel::select();
+        emit rowsWritten(QVariantList());
+        return ok;
+    }
+
+    const bool ok = QSqlRelationalTableModel::removeRows(row, count, parent);
+    if(ok)
+    {
+        RelationCache::invalidate(this->tableName());
+        emit rowsWritten(QVariantList());
+    }
+    return ok;
+}
+
+void TableModel::setDatabaseName(const QString &fileName)
+{
+    Q_D(TableModel);
+    if(!fileName.compare(d->databaseName, Qt::CaseInsensitive))
+        return;
+
+    // the same table in the other database, kept on the old one if it has
+    // no such table
+    if(d->completed && !d->tableName.isEmpty() && !d->switchTable(fileName, d->tableName))
+        return;
+
+    d->databaseName = fileName;
+    emit databaseNameChanged();
+}
+
+QString TableModel::databaseName() const
+{
+    Q_D(const TableModel);
+    return d->databaseName;
+}
+
+void TableModel::setTable(const QString &tableName)
+{
+    Q_D(TableModel);
+
+    // remove whitespace from the start and the end
+    const QString table = tableName.trimmed();
+
+    // back to the table shown while the other one is read
+    if(d->prefetcher && !table.compare(this->tableName(), Qt::CaseInsensitive))
+    {
+        d->cancelPrefetch();
+        return;
+    }
+
+    if(table.isEmpty() || !table.compare(this->tableName(), Qt::CaseInsensitive))
+        return;
+
+    if(d->completed)
+    {
+        // a prefetched table is announced when it is shown
+        if(d->switchTable(d->databaseName, table) && !d->prefetcher)
+            emit tableChanged();
+        return;
+    }
+
+    d->flushEdits(true);
+    d->tableName = table;
+    if(!d->databaseName.isEmpty())
+    {
+        d->open(d->databaseName);
+        QSqlRelationalTableModel::setTable(table);
+        Sql::invalidateStatements();
+        d->relations.clear();
+        d->updateRoles();
+        d->initKey();
+    }
+
+    emit tableChanged();
+}
+
+QString TableModel::tableName() const
+{
+    return QSqlRelationalTableModel::tableName();
+}
+
+int TableModel::selectedRows() const
+{
+    Q_D(const TableModel);
+    return d->selection.count();
+}
+
+void TableModel::setRelation(int column, const QSqlRelation &relation)
+{
+    Q_D(TableModel);
+    // kept out of QSqlRelationalTableModel, which would JOIN on every select
+    d->relations.setRelation(column, relation);
+    if(rowCount() > 0)
+        emit dataChanged(index(0, column), index(rowCount() - 1, column));
+}
+
+bool TableModel::setRelation(const QString &field, const QString &table,
+                             const QString &indexField, const QString &displayField)
+{
+    const int column = record().indexOf(field);
+    if(column < 0)
+        return false;
+
+    setRelation(column, QSqlRelation(table, indexField, displayField));
+    return true;
+}
+
+QSqlRelation TableModel::relation(int column) const
+{
+    Q_D(const TableModel);
+    return d->relations.relation(column);
+}
+
+QVariantList TableModel::relationEntries(int column) const
+{
+    Q_D(const TableModel);
+    return d->relations.entries(column, d->database());
+}
+
+bool TableModel::isRowSelected(int row) const
+{
+    Q_D(const TableModel);
+    return d->selection.contains(row);
+}
+
+QString TableModel::errorString() const
+{
+    Q_D(const TableModel);
+    return d->errorString.isEmpty() ? this->lastError().text() : d->errorString;
+}
+
+void TableModel::setFetchMode(TableModel::FetchMode mode)
+{
+    Q_D(TableModel);
+    if(d->fetchMode == mode)
+        return;
+
+    d->flushEdits(true);
+    d->fetchMode = mode;
+    d->detachSource();
+    if(!this->tableName().isEmpty())
+    {
+        // drop the rows cached by QSqlTableModel and load the table again
+        QSqlRelationalTableModel::clear();
+        QSqlRelationalTableModel::setTable(d->tableName);
+        d->updateRoles();
+        d->initKey();
+        this->refresh();
+    }
+
+    emit fetchModeChanged();
+}
+
+TableModel::FetchMode TableModel::fetchMode() const
+{
+    Q_D(const TableModel);
+    return d->fetchMode;
+}
+
+void TableModel::setPageSize(int rows)
+{
+    Q_D(TableModel);
+    if(rows <= 0 || rows == d->pageSize)
+        return;
+
+    // the page size is part of the source key
+    beginResetModel();
+    d->pageSize = rows;
+    d->attachSource();
+    endResetModel();
+
+    emit pageSizeChanged();
+}
+
+int TableModel::pageSize() const
+{
+    Q_D(const TableModel);
+    return d->pageSize;
+}
+
+void TableModel::setCachedPages(int pages)
+{
+    Q_D(TableModel);
+    if(pages <= 0 || pages == d->cachedPages)
+        return;
+
+    // a shared cache keeps the largest capacity of its views
+    d->cachedPages = pages;
+    if(!d->source->isShared() || pages > d->source->pages.capacity())
+        d->source->pages.setCapacity(pages);
+    emit cachedPagesChanged();
+}
+
+int TableModel::cachedPages() const
+{
+    Q_D(const TableModel);
+    return d->cachedPages;
+}
+
+void TableModel::sort(int column, Qt::SortOrder order)
+{
+    // a view asking to sort wants the rows now
+    setSort(column, order);
+    refresh();
+}
+
+void TableModel::setSort(int column, Qt::SortOrder order)
+{
+    setSortColumn(column);
+    setSortOrder(order);
+}
+
+void TableModel::setSortColumn(int column)
+{
+    Q_D(TableModel);
+    column = qMax(-1, column);
+    if(d->sortColumn == column)
+        return;
+
+    d->sortColumn = column;
+    d->refreshLater();
+    emit sortColumnChanged();
+}
+
+int TableModel::sortColumn() const
+{
+    Q_D(const TableModel);
+    return d->sortColumn;
+}
+
+void TableModel::setSortOrder(Qt::SortOrder order)
+{
+    Q_D(TableModel);
+    if(d->sortOrder == order)
+        return;
+
+    d->sortOrder = order;
+    if(d->sortColumn >= 0)
+        d->refreshLater();
+    emit sortOrderChanged();
+}
+
+Qt::SortOrder TableModel::sortOrder() const
+{
+    Q_D(const TableModel);
+    return d->sortOrder;
+}
+
+void TableModel::setFilter(const QString &filter)
+{
+    Q_D(TableModel);
+    const QString where = filter.trimmed();
+    if(d->filter == where)
+        return;
+
+    d->filter = where;
+    QSqlRelationalTableModel::setFilter(where);
+    d->refreshLater();
+    emit filterChanged();
+}
+
+QString TableModel::filter() const
+{
+    Q_D(const TableModel);
+    return d->filter;
+}
+
+void TableModel::setSearchText(const QString &text)
+{
+    Q_D(TableModel);
+    if(d->searchText == text)
+        return;
+
+    d->searchText = text;
+    d->refreshLater();
+    emit searchTextChanged();
+}
+
+QString TableModel::searchText() const
+{
+    Q_D(const TableModel);
+    return d->searchText;
+}
+
+void TableModel::setColumns(const QStringList &columns)
+{
+    Q_D(TableModel);
+    if(d->columns == columns)
+        return;
+
+    d->columns = columns;
+    if(d->completed)
+    {
+        // the column count and the roles change with the projection
+        beginResetModel();
+        d->updateRoles();
+        d->detachSource();
+        endResetModel();
+        d->refreshLater();
+    }
+
+    emit columnsChanged();
+}
+
+QStringList TableModel::columns() const
+{
+    Q_D(const TableModel);
+    return d->columns;
+}
+
+void TableModel::setShowDeleted(bool show)
+{
+    Q_D(TableModel);
+    if(d->showDeleted == show)
+        return;
+
+    d->showDeleted = show;
+    d->refreshLater();
+    emit showDeletedChanged();
+}
+
+bool TableModel::showDeleted() const
+{
+    Q_D(const TableModel);
+    return d->showDeleted;
+}
+
+void TableModel::setAutoIndex(bool enabled)
+{
+    Q_D(TableModel);
+    if(d->autoIndex == enabled)
+        return;
+
+    d->autoIndex = enabled;
+    emit autoIndexChanged();
+}
+
+bool TableModel::autoIndex() const
+{
+    Q_D(const TableModel);
+    return d->autoIndex;
+}
+
+void TableModel::setWriteBehind(bool enabled)
+{
+    Q_D(TableModel);
+    if(d->writeBehind == enabled)
+        return;
+
+    d->writeBehind = enabled;
+    if(!enabled)
+        d->flushEdits();
+
+    emit writeBehindChanged();
+}
+
+bool TableModel::writeBehind() const
+{
+    Q_D(const TableModel);
+    return d->writeBehind;
+}
+
+void TableModel::setFlushInterval(int msecs)
+{
+    Q_D(TableModel);
+    msecs = qMax(0, msecs);
+    if(d->flushTimer.interval() == msecs)
+        return;
+
+    d->flushTimer.setInterval(msecs);
+    emit flushIntervalChanged();
+}
+
+int TableModel::flushInterval() const
+{
+    Q_D(const TableModel);
+    return d->flushTimer.interval();
+}
+
+void TableModel::setAsynchronous(bool async)
+{
+    Q_D(TableModel);
+    if(d->asynchronous == async)
+        return;
+
+    d->asynchronous = async;
+    emit asynchronousChanged();
+}
+
+bool TableModel::isAsynchronous() const
+{
+    Q_D(const TableModel);
+    return d->asynchronous;
+}
+
+void TableModel::setReadOnly(bool readOnly)
+{
+    Q_D(TableModel);
+    if(d->readOnly == readOnly)
+        return;
+
+    // the table is opened again through the other connection
+    d->flushEdits(true);
+    d->readOnly = readOnly;
+    if(d->completed && !d->tableName.isEmpty() && !d->switchTable(d->databaseName, d->tableName))
+    {
+        d->readOnly = !readOnly;
+        return;
+    }
+
+    emit readOnlyChanged();
+}
+
+bool TableModel::isReadOnly() const
+{
+    Q_D(const TableModel);
+    return d->readOnly;
+}
+
+void TableModel::setLiveSync(bool enabled)
+{
+    Q_D(TableModel);
+    if(d->liveSync == enabled)
+        return;
 
-    QString databaseName;
-    QString tableName;
-    QString errorString;
-    QItemSelectionModel *selectionModel = nullptr;
-    mutable QHash<int, QByteArray> roles;
-    TableModel *q_ptr = nullptr;
-};
+    d->liveSync = enabled;
+    d->updateFeed();
+    emit liveSyncChanged();
+}
 
+bool TableModel::liveSync() const
+{
+    Q_D(const TableModel);
+    return d->liveSync;
+}
 
-TableModel::TableModel(QObject *parent)
-    : QSqlRelationalTableModel(parent, Sql::database())
-    , d_ptr(new TableModelPrivate())
+void TableModel::setCountStrategy(CountStrategy strategy)
 {
     Q_D(TableModel);
-    d->q_ptr = this;
+    if(d->countStrategy == strategy)
+        return;
 
-    setEditStrategy(OnFieldChange);
+    d->countStrategy = strategy;
+    emit countStrategyChanged();
 }
 
-TableModel::~TableModel()
+TableModel::CountStrategy TableModel::countStrategy() const
 {
+    Q_D(const TableModel);
+    return d->countStrategy;
+}
 
+bool TableModel::isCountExact() const
+{
+    Q_D(const TableModel);
+    return d->countKnown;
 }
 
-void TableModel::classBegin()
+void TableModel::setPrefetch(bool enabled)
 {
-    qDebug(lcTableModel) << "TableModel::classBegin";
+    Q_D(TableModel);
+    if(d->prefetch == enabled)
+        return;
+
+    d->prefetch = enabled;
+    emit prefetchChanged();
 }
 
-void TableModel::componentComplete()
+bool TableModel::prefetch() const
+{
+    Q_D(const TableModel);
+    return d->prefetch;
+}
+
+void TableModel::setMigrate(bool enabled)
 {
     Q_D(TableModel);
-    qDebug(lcTableModel) << "TableModel::componentComplete";
+    if(d->migrate == enabled)
+        return;
 
-    // connect signals slot
+    d->migrate = enabled;
+    if(enabled && d->completed)
+        d->open(d->databaseName);
+    emit migrateChanged();
+}
 
-    if(d->databaseName.isEmpty() && d->tableName.isEmpty())
-    {
-        // use default database and table
-        Sql::memoryDatabase();
-        d->databaseName = ":memory:";
-        d->tableName = "books";
-    }
+bool TableModel::migrate() const
+{
+    Q_D(const TableModel);
+    return d->migrate;
+}
 
-    this->database().setDatabaseName(d->databaseName);
-    this->setTable(d->tableName);
+bool TableModel::isLoading() const
+{
+    Q_D(const TableModel);
+    return d->loading;
+}
 
-    qDebug() << "database:" << this->database().databaseName()
-             << ", table:"  << this->tableName();
+qreal TableModel::progress() const
+{
+    Q_D(const TableModel);
+    if(d->source->tasksIssued == 0)
+        return 1.0;
 
-    this->select();
+    return qreal(d->source->tasksDone) / d->source->tasksIssued;
 }
 
-QHash<int, QByteArray> TableModel::roleNames() const
+bool TableModel::isImporting() const
 {
     Q_D(const TableModel);
-    QHash<int, QByteArray> roles;
+    return d->importer != nullptr;
+}
 
-    // for checked
-    roles.insert(Qt::CheckStateRole, QByteArrayLiteral("checkState"));
+bool TableModel::isExporting() const
+{
+    Q_D(const TableModel);
+    return d->exporter != nullptr;
+}
 
-    // database table fileds
-    QSqlRecord record = this->record();
-    for (int i = 0; i < record.count(); ++i)
-    {
-        roles.insert(Qt::UserRole + 1 + i, record.fieldName(i).toUtf8());
-    }
+QAbstractItemModel *TableModel::horizontalHeader() const
+{
+    Q_D(const TableModel);
+    return d->horizontalHeader;
+}
 
-    d->roles = roles;
+TableMetrics *TableModel::metrics() const
+{
+    Q_D(const TableModel);
+    return d->metrics;
+}
 
-    return roles;
+ColumnGeometry *TableModel::geometry() const
+{
+    Q_D(const TableModel);
+    return d->geometry;
 }
 
-bool TableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+bool TableModel::storedValues(const QVariantList &keys, const QString &field, QVariantList *values) const
 {
-    Q_D(TableModel);
-    if(!index.isValid())
+    Q_D(const TableModel);
+    const int column = record().indexOf(field);
+    if(d->fetchMode != WindowedFetch || column < 0)
         return false;
 
-    if(role < Qt::UserRole)
+    // the oldest pending edit holds the value before it, the cache the
+    // value of the rows not edited
+    const QHash<QString, int> rows = d->cachedRows();
+    for (const QVariant &key : keys)
     {
-        if(role == Qt::CheckStateRole)
+        const QString id = key.toString();
+        QVariant value;
+        bool pending = false;
+        for (const QMap<QString, TableModelPrivate::PendingEdit> *queue : { &d->flushing, &d->edits })
         {
-            QItemSelectionModel::SelectionFlag flag = value.toBool()
-                    ? QItemSelectionModel::Select
-                    : QItemSelectionModel::Deselect;
-            d->selectionModel->select(index, flag);
-            emit selectedRowsChanged();
-            emit dataChanged(index, index, {role});
-            return true;
+            QMap<QString, TableModelPrivate::PendingEdit>::const_iterator edit = queue->constFind(id);
+            if(!pending && edit != queue->constEnd() && edit->stored.contains(column))
+            {
+                value = edit->stored.value(column);
+                pending = true;
+            }
         }
 
-        return QSqlRelationalTableModel::setData(index, value, role);
-    }
+        const int row = rows.value(id, -1);
+        if(!pending && (row < 0 || !d->source->pages.value(row, column, &value)))
+            return false;
 
-    int column = role - Qt::UserRole - 1;
-    QModelIndex modelIndex = createIndex(index.row(), column);
-    return QSqlRelationalTableModel::setData(modelIndex, value, Qt::EditRole);
+        *values << value;
+    }
+    return true;
 }
 
-QVariant TableModel::data(const QModelIndex &index, int role) const
+QAbstractItemModel *TableModel::verticalHeader() const
 {
     Q_D(const TableModel);
-    if (!index.isValid())
-        return QVariant();
+    return d->verticalHeader;
+}
 
-    QVariant value;
-    if(role < Qt::UserRole)
-    {
-        if(role == Qt::CheckStateRole)
-            return d->selectionModel->isSelected(index);
+void TableModel::setJournalMode(const QString &mode)
+{
+    Q_D(TableModel);
+    SqlProfile profile = Sql::profile();
+    if(!profile.journalMode.compare(mode, Qt::CaseInsensitive))
+        return;
 
-        return QSqlRelationalTableModel::data(index, role);
-    }
+    profile.journalMode = mode;
+    d->setProfile(profile);
+}
 
-    int column = role - Qt::UserRole - 1;
-    QModelIndex modelIndex = createIndex(index.row(), column);
-    return QSqlRelationalTableModel::data(modelIndex, Qt::DisplayRole);
+QString TableModel::journalMode() const
+{
+    return Sql::profile().journalMode;
 }
 
-void TableModel::setDatabaseName(const QString &fileName)
+void TableModel::setSynchronous(const QString &mode)
 {
     Q_D(TableModel);
-    if(!fileName.compare(d->databaseName, Qt::CaseInsensitive))
+    SqlProfile profile = Sql::profile();
+    if(!profile.synchronous.compare(mode, Qt::CaseInsensitive))
         return;
 
-    // TODO:
-    // reset model
-    // verify table exists
-    // load table record
-
-    d->databaseName = fileName;
-    emit databaseNameChanged();
+    profile.synchronous = mode;
+    d->setProfile(profile);
 }
 
-QString TableModel::databaseName() const
+QString TableModel::synchronous() const
 {
-    Q_D(const TableModel);
-    return d->databaseName;
+    return Sql::profile().synchronous;
 }
 
-void TableModel::setTable(const QString &tableName)
+void TableModel::setCacheSize(int size)
 {
     Q_D(TableModel);
+    SqlProfile profile = Sql::profile();
+    if(profile.cacheSize == size)
+        return;
 
-    // remove whitespace from the start and the end
-    const QString table = tableName.trimmed();
+    profile.cacheSize = size;
+    d->setProfile(profile);
+}
 
-    if(table.isEmpty() || !table.compare(this->tableName(), Qt::CaseInsensitive))
+int TableModel::cacheSize() const
+{
+    return Sql::profile().cacheSize;
+}
+
+void TableModel::setMmapSize(qint64 size)
+{
+    Q_D(TableModel);
+    SqlProfile profile = Sql::profile();
+    if(profile.mmapSize == size)
         return;
 
-    d->tableName = table;
-    if(!d->databaseName.isEmpty())
-        QSqlRelationalTableModel::setTable(table);
+    profile.mmapSize = size;
+    d->setProfile(profile);
+}
 
-    emit tableChanged();
+qint64 TableModel::mmapSize() const
+{
+    return Sql::profile().mmapSize;
 }
 
-QString TableModel::tableName() const
+void TableModel::setTempStore(const QString &store)
 {
-    return QSqlRelationalTableModel::tableName();
+    Q_D(TableModel);
+    SqlProfile profile = Sql::profile();
+    if(!profile.tempStore.compare(store, Qt::CaseInsensitive))
+        return;
+
+    profile.tempStore = store;
+    d->setProfile(profile);
 }
 
-int TableModel::selectedRows() const
+QString TableModel::tempStore() const
 {
-    Q_D(const TableModel);
-    if(!d->selectionModel)
-        return 0;
+    return Sql::profile().tempStore;
+}
+
+void TableModel::setBusyTimeout(int msecs)
+{
+    Q_D(TableModel);
+    SqlProfile profile = Sql::profile();
+    if(profile.busyTimeout == msecs)
+        return;
 
-    return d->selectionModel->selectedIndexes().count();
+    profile.busyTimeout = msecs;
+    d->setProfile(profile);
 }
 
-QString TableModel::errorString() const
+int TableModel::busyTimeout() const
 {
-    Q_D(const TableModel);
-    return d->errorString.isEmpty() ? this->lastError().text() : d->errorString;
+    return Sql::profile().busyTimeout;
 }
 
 bool TableModel::select()
@@ -224,19 +3506,123 @@ bool TableModel::select()
     return this->refresh();
 }
 
+bool TableModel::submit()
+{
+    Q_D(TableModel);
+    // no edits to write, the edit strategy is left out
+    if(d->readOnly)
+        return true;
+
+    // write behind edits go now instead of after the interval
+    d->flushEdits();
+    return QSqlRelationalTableModel::submit();
+}
+
 bool TableModel::refresh()
 {
     Q_D(TableModel);
-    if(!this->database().tables().contains(this->tableName()))
+    d->refreshQueued = false;
+    d->updateSearch();
+    d->clearLazyValues();
+    const QStringList indexes = d->autoIndex && !d->readOnly ? d->indexStatements() : QStringList();
+    if(d->fetchMode == WindowedFetch && d->asynchronous)
+    {
+        // a missing table is reported by the failing count
+        beginResetModel();
+        d->initKey();
+        const bool shared = d->attachSource();
+        d->setCountKnown(d->source->count >= 0);
+        d->rowCount = d->countKnown ? d->source->count : qMax(0, d->source->estimate);
+
+        // a first page read before the count, e.g. by a prefetch
+        const int keyIndex = d->keyColumn < 0 ? record().count() : d->keyColumn;
+        if(!d->countKnown && d->source->estimate < 0 && d->source->pages.contains(0))
+            d->rowCount = d->source->pages.column(0, keyIndex).count();
+        endResetModel();
+
+        // indexes are created on the worker in front of the count
+        for (const QString &statement : indexes)
+        {
+            QueryTask task;
+            task.kind = QueryTask::Exec;
+            task.statement = statement;
+            d->post(task);
+        }
+
+        // the rows of another view, counted or in counting already
+        if(shared)
+        {
+            d->updateLoading();
+            return true;
+        }
+
+        // the estimate shows the rows until the count arrives
+        if(d->countStrategy == EstimatedCount)
+        {
+            QueryTask estimate;
+            estimate.kind = QueryTask::Estimate;
+            estimate.statement = d->estimateStatement(&estimate.values);
+            if(!estimate.statement.isEmpty())
+                d->post(estimate);
+        }
+
+        QueryTask count;
+        count.kind = QueryTask::Count;
+        count.statement = d->countStatement(&count.values);
+        d->post(count);
+        d->requestPage(0);
+
+        return true;
+    }
+
+    // one PRAGMA, the table names are read again after DDL only
+    SchemaCache::validate(d->database());
+    if(!SchemaCache::hasTable(d->database(), this->tableName()))
     {
         QString msg = QString("Can not open table '%1' in '%2'")
-                .arg(this->tableName(), this->database().databaseName());
+                .arg(this->tableName(), d->database().databaseName());
         qWarning(lcTableModel) << msg;
         d->errorString = msg;
         emit error(msg);
         return false;
     }
 
+    for (const QString &statement : indexes)
+        d->indexCreated(statement, d->exec(statement, QVariantList()), QString());
+
+    if(d->fetchMode == WindowedFetch)
+    {
+        beginResetModel();
+        d->initKey();
+        const bool shared = d->attachSource() && d->source->count >= 0;
+        const int estimate = shared || d->countStrategy != EstimatedCount ? -1 : d->estimateRows();
+        bool ok = true;
+        if(shared)
+            d->rowCount = d->source->count;
+        else if(estimate >= 0)
+            d->rowCount = d->source->estimate = estimate;
+        else
+            ok = d->countRows(&d->rowCount);
+        d->setCountKnown(ok && estimate < 0);
+        endResetModel();
+
+        // the estimate is replaced by the count of the worker
+        if(estimate >= 0)
+        {
+            QueryTask count;
+            count.kind = QueryTask::Count;
+            count.statement = d->countStatement(&count.values);
+            d->post(count);
+        }
+        else if(ok && !shared)
+        {
+            d->source->setCount(d->rowCount);
+        }
+        return ok;
+    }
+
+    QSqlRelationalTableModel::setSort(d->sortColumn, d->sortOrder);
+    QSqlRelationalTableModel::setFilter(d->cachedFilter());
     bool ok = QSqlRelationalTableModel::select();
     if(!ok)
     {
@@ -257,6 +3643,75 @@ int TableModel::add()
 int TableModel::insert(int row)
 {
     Q_D(TableModel);
+    if(!d->writable("insert rows"))
+        return -1;
+
+    if(d->fetchMode == WindowedFetch)
+    {
+        const bool hasState = d->stateColumn >= 0;
+        QSqlQuery query = Sql::prepare(hasState
+                      ? QString("INSERT INTO %1 (state) VALUES (?)").arg(d->escapeTable())
+                      : QString("INSERT INTO %1 DEFAULT VALUES").arg(d->escapeTable()),
+                      d->database());
+        if(hasState)
+            query.addBindValue(TableModel::PendingStatus);
+
+        if(!query.exec())
+        {
+            d->reportError("Insert record failed " + query.lastError().text()
+                           + this->databaseName() + this->tableName());
+            return -1;
+        }
+
+        // the id is read while the query is active, then it is finished
+        // for the next insert
+        const QVariant key = query.lastInsertId();
+        query.finish();
+
+        RelationCache::invalidate(this->tableName());
+        emit rowsWritten(QVariantList() << key);
+
+        // the new row is the last one only in key order over all live rows,
+        // elsewhere the views read their pages again and the count follows;
+        // its row is not known until then
+        const bool keyOrder = d->searchQuery.isEmpty() && d->sortField().isEmpty();
+        if(!keyOrder || !d->filter.isEmpty() || (d->softDelete() && d->showDeleted))
+        {
+            d->invalidatePages(0);
+            if(d->rowCount > 0)
+            {
+                emit dataChanged(index(0, 0), index(d->rowCount - 1, columnCount() - 1));
+                d->source->changeRows(this, 0, d->rowCount - 1);
+            }
+
+            QueryTask count;
+            count.kind = QueryTask::Count;
+            count.statement = d->countStatement(&count.values);
+            d->post(count);
+            return -1;
+        }
+
+        QSqlRecord record;
+        const bool known = d->readRow(key, &record);
+
+        row = d->rowCount;
+        beginInsertRows(QModelIndex(), row, row);
+        ++d->rowCount;
+        if(known)
+        {
+            d->source->pages.setRecord(row, record);
+            ++d->source->serial;
+        }
+        else
+        {
+            d->dropPage(d->source->pages.pageOf(row));
+        }
+        endInsertRows();
+        d->source->insertRows(this, row, row);
+
+        return row;
+    }
+
     QSqlRecord rec = this->record();
     for (int i = 0; i < rec.count(); ++i)
         rec.setGenerated(i, false);
@@ -275,6 +3730,8 @@ int TableModel::insert(int row)
         return -1;
     }
 
+    RelationCache::invalidate(this->tableName());
+    emit rowsWritten(QVariantList());
     return row;
 }
 
@@ -293,22 +3750,20 @@ int TableModel::removeSelected()
 {
     Q_D(TableModel);
     int total = 0;
+    if(d->selection.isEmpty() || !d->writable("remove rows"))
+        return total;
 
-    QModelIndexList list = d->selectionModel->selectedIndexes();
-    typedef QList<QModelIndex>::iterator ModelIterator;
-    ModelIterator begin = list.begin();
-    ModelIterator end = list.end();
-    std::sort(begin, end);
+    // removed rows leave the selection through rowsRemoved
+    const QVector<RowRange> ranges = d->selection.ranges();
+    if(d->canBatch())
+        return d->removeRanges(ranges);
 
-    while (!list.isEmpty())
+    for (int i = ranges.count() - 1; i >= 0; --i)
     {
-        QModelIndex last = list.takeLast();
-        int currentRow = last.row();
-
-        if(removeRow(currentRow))
+        for (int row = ranges.at(i).second; row >= ranges.at(i).first; --row)
         {
-            d->selectionModel->select(last, QItemSelectionModel::Deselect);
-            ++total;
+            if(removeRow(row))
+                ++total;
         }
     }
 
@@ -318,31 +3773,176 @@ int TableModel::removeSelected()
 bool TableModel::recoverRow(int row)
 {
     Q_D(TableModel);
-    QModelIndex modelIndex = createIndex(row, 0);
-    int role = d->roles.key("deleted_at");
-    return this->setData(modelIndex, QVariant(), role);
+    if(d->deletedAtColumn < 0 || row < 0 || row >= rowCount() || !d->writable("recover rows"))
+        return false;
+
+    // a recovered row leaves the trash
+    if(d->canBatch())
+        return d->recoverRanges(QVector<RowRange>() << qMakePair(row, row)) > 0;
+
+    QModelIndex modelIndex = createIndex(row, d->deletedAtColumn);
+    return this->setData(modelIndex, QVariant(), Qt::EditRole);
 }
 
 int TableModel::recoverSelected()
 {
     Q_D(TableModel);
     int total = 0;
+    if(d->selection.isEmpty() || !d->writable("recover rows"))
+        return total;
 
-    QModelIndexList list = d->selectionModel->selectedIndexes();
-    typedef QList<QModelIndex>::iterator ModelIterator;
-    ModelIterator begin = list.begin();
-    ModelIterator end = list.end();
-    std::sort(begin, end);
+    const QVector<RowRange> ranges = d->selection.ranges();
+    d->selection.clear();
+    emit selectedRowsChanged();
 
-    while (!list.isEmpty())
+    if(d->canBatch())
     {
-        QModelIndex last = list.takeLast();
-        if(this->recoverRow(last.row()))
+        total = d->recoverRanges(ranges);
+        if(total == 0)
         {
-            d->selectionModel->select(last, QItemSelectionModel::Deselect);
-            ++total;
+            // keep the selection for another try
+            for (const RowRange &range : ranges)
+                d->selection.select(range.first, range.second);
+            emit selectedRowsChanged();
+        }
+        return total;
+    }
+
+    for (int i = ranges.count() - 1; i >= 0; --i)
+    {
+        for (int row = ranges.at(i).second; row >= ranges.at(i).first; --row)
+        {
+            if(this->recoverRow(row))
+                ++total;
         }
     }
 
     return total;
 }
+
+bool TableModel::importFile(const QUrl &url, const QString &format)
+{
+    Q_D(TableModel);
+    if(d->importer)
+    {
+        d->reportError("Import is running already");
+        return false;
+    }
+
+    if(!d->writable("import"))
+        return false;
+
+    const QString fileName = localFile(url);
+    Importer::Format fileFormat;
+    if(!Importer::formatOf(format, fileName, &fileFormat))
+    {
+        d->reportError("Unknown import format '" + format + "' of " + fileName);
+        return false;
+    }
+
+    d->importer = new Importer(d->database().databaseName(), this->tableName(), fileName, fileFormat);
+    connect(d->importer, &Importer::progress, this, &TableModel::importProgress);
+    connect(d->importer, &Importer::finished, this, [this, d](bool ok, qint64 rows, const QString &message) {
+        d->importer->deleteLater();
+        d->importer = nullptr;
+        emit importingChanged();
+
+        if(!ok)
+            d->reportError(message);
+
+        // the view sees the imported rows by one reset
+        if(rows > 0)
+        {
+            RelationCache::invalidate(this->tableName());
+            refresh();
+            emit rowsWritten(QVariantList());
+        }
+
+        emit importFinished(ok, rows);
+    });
+
+    d->importer->start();
+    emit importingChanged();
+
+    return true;
+}
+
+bool TableModel::exportTo(const QUrl &url, const QString &format)
+{
+    Q_D(TableModel);
+    if(d->exporter)
+    {
+        d->reportError("Export is running already");
+        return false;
+    }
+
+    const QString fileName = localFile(url);
+    Exporter::Format fileFormat;
+    if(!Exporter::formatOf(format, fileName, &fileFormat))
+    {
+        d->reportError("Unknown export format '" + format + "' of " + fileName);
+        return false;
+    }
+
+    QVariantList values;
+    const QString statement = d->exportStatement(&values);
+    d->exporter = new Exporter(d->database().databaseName(), statement,
+                               values, fileName, fileFormat);
+    connect(d->exporter, &Exporter::progress, this, &TableModel::exportProgress);
+    connect(d->exporter, &Exporter::finished, this, [this, d](bool ok, qint64 rows, const QString &message) {
+        d->exporter->deleteLater();
+        d->exporter = nullptr;
+        emit exportingChanged();
+
+        if(!ok)
+            d->reportError(message);
+
+        emit exportFinished(ok, rows);
+    });
+
+    d->exporter->start();
+    emit exportingChanged();
+
+    return true;
+}
+
+void TableModel::selectRange(int first, int last)
+{
+    Q_D(TableModel);
+    first = qMax(0, first);
+    last = qMin(last, rowCount() - 1);
+    if(first > last)
+        return;
+
+    d->selection.select(first, last);
+    d->selectionChanged(first, last);
+}
+
+void TableModel::deselectRange(int first, int last)
+{
+    Q_D(TableModel);
+    first = qMax(0, first);
+    last = qMin(last, rowCount() - 1);
+    if(first > last)
+        return;
+
+    d->selection.deselect(first, last);
+    d->selectionChanged(first, last);
+}
+
+void TableModel::selectAll()
+{
+    this->selectRange(0, rowCount() - 1);
+}
+
+void TableModel::clearSelection()
+{
+    Q_D(TableModel);
+    if(d->selection.isEmpty())
+        return;
+
+    const int first = d->selection.ranges().first().first;
+    const int last = d->selection.ranges().last().second;
+    d->selection.clear();
+    d->selectionChanged(first, last);
+}
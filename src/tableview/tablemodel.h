@@ -26,6 +26,10 @@
 
 #include <QSqlRelationalTableModel>
 #include <QQmlParserStatus>
+#include <QUrl>
+
+#include "columngeometry.h"
+#include "tablemetrics.h"
 
 class TableModelPrivate;
 class TableModel : public QSqlRelationalTableModel,  public QQmlParserStatus
@@ -35,9 +39,42 @@ class TableModel : public QSqlRelationalTableModel,  public QQmlParserStatus
     QScopedPointer<TableModelPrivate> d_ptr;
     Q_PROPERTY(QString database READ databaseName WRITE setDatabaseName NOTIFY databaseNameChanged)
     Q_PROPERTY(QString table READ tableName WRITE setTable NOTIFY tableChanged)
-    Q_PROPERTY(QString selectedRows READ selectedRows NOTIFY selectedRowsChanged)
+    Q_PROPERTY(int selectedRows READ selectedRows NOTIFY selectedRowsChanged)
     Q_PROPERTY(QString errorString READ errorString)
-    Q_ENUMS(ItemStatus)
+    Q_PROPERTY(FetchMode fetchMode READ fetchMode WRITE setFetchMode NOTIFY fetchModeChanged)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged)
+    Q_PROPERTY(int cachedPages READ cachedPages WRITE setCachedPages NOTIFY cachedPagesChanged)
+    Q_PROPERTY(QStringList columns READ columns WRITE setColumns NOTIFY columnsChanged)
+    Q_PROPERTY(int sortColumn READ sortColumn WRITE setSortColumn NOTIFY sortColumnChanged)
+    Q_PROPERTY(Qt::SortOrder sortOrder READ sortOrder WRITE setSortOrder NOTIFY sortOrderChanged)
+    Q_PROPERTY(QString filter READ filter WRITE setFilter NOTIFY filterChanged)
+    Q_PROPERTY(QString searchText READ searchText WRITE setSearchText NOTIFY searchTextChanged)
+    Q_PROPERTY(bool showDeleted READ showDeleted WRITE setShowDeleted NOTIFY showDeletedChanged)
+    Q_PROPERTY(bool autoIndex READ autoIndex WRITE setAutoIndex NOTIFY autoIndexChanged)
+    Q_PROPERTY(bool writeBehind READ writeBehind WRITE setWriteBehind NOTIFY writeBehindChanged)
+    Q_PROPERTY(int flushInterval READ flushInterval WRITE setFlushInterval NOTIFY flushIntervalChanged)
+    Q_PROPERTY(bool liveSync READ liveSync WRITE setLiveSync NOTIFY liveSyncChanged)
+    Q_PROPERTY(CountStrategy countStrategy READ countStrategy WRITE setCountStrategy NOTIFY countStrategyChanged)
+    Q_PROPERTY(bool countExact READ isCountExact NOTIFY countExactChanged)
+    Q_PROPERTY(bool asynchronous READ isAsynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
+    Q_PROPERTY(bool readOnly READ isReadOnly WRITE setReadOnly NOTIFY readOnlyChanged)
+    Q_PROPERTY(bool prefetch READ prefetch WRITE setPrefetch NOTIFY prefetchChanged)
+    Q_PROPERTY(bool migrate READ migrate WRITE setMigrate NOTIFY migrateChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(bool importing READ isImporting NOTIFY importingChanged)
+    Q_PROPERTY(bool exporting READ isExporting NOTIFY exportingChanged)
+    Q_PROPERTY(QString journalMode READ journalMode WRITE setJournalMode NOTIFY profileChanged)
+    Q_PROPERTY(QString synchronous READ synchronous WRITE setSynchronous NOTIFY profileChanged)
+    Q_PROPERTY(int cacheSize READ cacheSize WRITE setCacheSize NOTIFY profileChanged)
+    Q_PROPERTY(qint64 mmapSize READ mmapSize WRITE setMmapSize NOTIFY profileChanged)
+    Q_PROPERTY(QString tempStore READ tempStore WRITE setTempStore NOTIFY profileChanged)
+    Q_PROPERTY(int busyTimeout READ busyTimeout WRITE setBusyTimeout NOTIFY profileChanged)
+    Q_PROPERTY(QAbstractItemModel *horizontalHeader READ horizontalHeader CONSTANT)
+    Q_PROPERTY(QAbstractItemModel *verticalHeader READ verticalHeader CONSTANT)
+    Q_PROPERTY(TableMetrics *metrics READ metrics CONSTANT)
+    Q_PROPERTY(ColumnGeometry *geometry READ geometry CONSTANT)
+    Q_ENUMS(ItemStatus FetchMode CountStrategy)
 public:
     enum ItemStatus {
         SavedStatus = 0,
@@ -48,6 +85,16 @@ public:
         DeletedStatus
     };
 
+    enum FetchMode {
+        CachedFetch = 0,    // QSqlTableModel caches every fetched row
+        WindowedFetch       // only a bounded set of pages around the view
+    };
+
+    enum CountStrategy {
+        ExactCount = 0,     // no rows until COUNT(*) of the select is read
+        EstimatedCount      // estimated rows at once, COUNT(*) on the worker
+    };
+
     explicit TableModel(QObject *parent = nullptr);
     ~TableModel() override;
 
@@ -55,8 +102,17 @@ public:
     void componentComplete() override;
 
     QHash<int, QByteArray> roleNames() const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent = QModelIndex()) const override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    void sort(int column, Qt::SortOrder order) override;
+    void setSort(int column, Qt::SortOrder order) override;
+    void setFilter(const QString &filter) override;
 
     void setDatabaseName(const QString &fileName);
     QString databaseName() const;
@@ -64,18 +120,170 @@ public:
     void setTable(const QString &tableName) override;
     QString tableName() const;
 
+    void setRelation(int column, const QSqlRelation &relation) override;
+    Q_INVOKABLE bool setRelation(const QString &field, const QString &table,
+                                 const QString &indexField, const QString &displayField);
+    QSqlRelation relation(int column) const;
+    // {key, display} pairs of a relation column, e.g. for a combo box
+    Q_INVOKABLE QVariantList relationEntries(int column) const;
+
     int selectedRows() const;
+    Q_INVOKABLE bool isRowSelected(int row) const;
 
     QString errorString() const;
 
+    void setFetchMode(FetchMode mode);
+    FetchMode fetchMode() const;
+
+    void setPageSize(int rows);
+    int pageSize() const;
+
+    void setCachedPages(int pages);
+    int cachedPages() const;
+
+    // fields shown in this order, windowed fetch only; TEXT and BLOB
+    // fields among them are read per row when asked for
+    void setColumns(const QStringList &columns);
+    QStringList columns() const;
+
+    // applied by one select once back in the event loop
+    void setSortColumn(int column);
+    int sortColumn() const;
+
+    void setSortOrder(Qt::SortOrder order);
+    Qt::SortOrder sortOrder() const;
+
+    QString filter() const;
+
+    // full text search on the <table>_fts table, ranked by bm25()
+    void setSearchText(const QString &text);
+    QString searchText() const;
+
+    // the trash: rows with deleted_at set, removing them there deletes them
+    void setShowDeleted(bool show);
+    bool showDeleted() const;
+
+    // create an index on the sorted and filtered columns when first used
+    void setAutoIndex(bool enabled);
+    bool autoIndex() const;
+
+    // windowed fetch only: edits go to the cache at once and are written
+    // by the worker in one transaction every flushInterval ms
+    void setWriteBehind(bool enabled);
+    bool writeBehind() const;
+
+    void setFlushInterval(int msecs);
+    int flushInterval() const;
+
+    void setAsynchronous(bool async);
+    bool isAsynchronous() const;
+
+    // rows written by other connections and processes are read from the
+    // _changes log: windowed caches patch or drop the changed rows and count
+    // again, cached mode selects again. Not for read only models
+    void setLiveSync(bool enabled);
+    bool liveSync() const;
+
+    // windowed fetch only: the estimate comes from sqlite_stat1 or the key
+    // range, scaled by the filter on a sample of rows; the rows are inserted
+    // or removed once the exact count is in
+    void setCountStrategy(CountStrategy strategy);
+    CountStrategy countStrategy() const;
+    bool isCountExact() const;
+
+    // opens the database read only and immutable with a large mmap, the
+    // file must not change while it is shown; edits, removes, inserts and
+    // imports are refused and windowed pages are read by several threads
+    void setReadOnly(bool readOnly);
+    bool isReadOnly() const;
+
+    // asynchronous windowed switches show the old table until the first
+    // page of the new one is read
+    void setPrefetch(bool enabled);
+    bool prefetch() const;
+
+    // applies :/migrations to the database file when it is opened, the
+    // memory database is always migrated; files are left as they are
+    void setMigrate(bool enabled);
+    bool migrate() const;
+
+    bool isLoading() const;
+    qreal progress() const;
+
+    bool isImporting() const;
+    bool isExporting() const;
+
+    QAbstractItemModel *horizontalHeader() const;
+    QAbstractItemModel *verticalHeader() const;
+
+    TableMetrics *metrics() const;
+    ColumnGeometry *geometry() const;
+
+    // windowed fetch only: a field of the cached rows by key, as stored in
+    // the table before the pending edits; false unless all rows are cached
+    bool storedValues(const QVariantList &keys, const QString &field, QVariantList *values) const;
+
+    // SQLite connection profile, shared by all pooled connections
+    void setJournalMode(const QString &mode);
+    QString journalMode() const;
+
+    void setSynchronous(const QString &mode);
+    QString synchronous() const;
+
+    void setCacheSize(int size);
+    int cacheSize() const;
+
+    void setMmapSize(qint64 size);
+    qint64 mmapSize() const;
+
+    void setTempStore(const QString &store);
+    QString tempStore() const;
+
+    void setBusyTimeout(int msecs);
+    int busyTimeout() const;
+
 signals:
     void databaseNameChanged();
     void tableChanged();
     void selectedRowsChanged();
+    void fetchModeChanged();
+    void pageSizeChanged();
+    void cachedPagesChanged();
+    void columnsChanged();
+    void sortColumnChanged();
+    void sortOrderChanged();
+    void filterChanged();
+    void searchTextChanged();
+    void showDeletedChanged();
+    void autoIndexChanged();
+    void writeBehindChanged();
+    void flushIntervalChanged();
+    void asynchronousChanged();
+    void liveSyncChanged();
+    void countStrategyChanged();
+    void countExactChanged();
+    void readOnlyChanged();
+    void prefetchChanged();
+    void migrateChanged();
+    void loadingChanged();
+    void progressChanged();
+    void profileChanged();
+    void importingChanged();
+    void importProgress(qint64 rows, qreal fraction, qreal rowsPerSecond);
+    void importFinished(bool ok, qint64 rows);
+    void exportingChanged();
+    void exportProgress(qint64 rows);
+    void exportFinished(bool ok, qint64 rows);
     void error(const QString &message);
 
+    // by key, e.g. for the totals of an AggregateModel; written rows with no
+    // keys known (cached mode, imports) come as an empty list
+    void rowsAboutToBeWritten(const QVariantList &keys);
+    void rowsWritten(const QVariantList &keys);
+
 public slots:
     bool select() override;
+    bool submit() override;
     virtual bool refresh();
 
     int add();
@@ -84,6 +292,14 @@ public slots:
     int removeSelected();
     bool recoverRow(int row);
     int recoverSelected();
+
+    bool importFile(const QUrl &url, const QString &format = QString());
+    bool exportTo(const QUrl &url, const QString &format = QString());
+
+    void selectRange(int first, int last);
+    void deselectRange(int first, int last);
+    void selectAll();
+    void clearSelection();
 };
 
 #endif // TABLEMODEL_H
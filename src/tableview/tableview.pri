@@ -0,0 +1,49 @@
+# The model, SQL and view classes of the table view, shared by the
+# application and the benchmarks
+QT += quick sql
+
+CONFIG += c++11
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+        $$PWD/aggregatemodel.cpp \
+        $$PWD/changefeed.cpp \
+        $$PWD/columngeometry.cpp \
+        $$PWD/datasource.cpp \
+        $$PWD/exporter.cpp \
+        $$PWD/gridlines.cpp \
+        $$PWD/headermodel.cpp \
+        $$PWD/importer.cpp \
+        $$PWD/migration.cpp \
+        $$PWD/pagecache.cpp \
+        $$PWD/qmltypes.cpp \
+        $$PWD/queryworker.cpp \
+        $$PWD/relationcache.cpp \
+        $$PWD/rowselection.cpp \
+        $$PWD/schemacache.cpp \
+        $$PWD/tablemetrics.cpp \
+        $$PWD/tablemodel.cpp
+
+HEADERS += \
+    $$PWD/aggregatemodel.h \
+    $$PWD/changefeed.h \
+    $$PWD/columngeometry.h \
+    $$PWD/datasource.h \
+    $$PWD/exporter.h \
+    $$PWD/gridlines.h \
+    $$PWD/headermodel.h \
+    $$PWD/importer.h \
+    $$PWD/migration.h \
+    $$PWD/pagecache.h \
+    $$PWD/qmltypes.h \
+    $$PWD/queryworker.h \
+    $$PWD/relationcache.h \
+    $$PWD/rowselection.h \
+    $$PWD/schemacache.h \
+    $$PWD/sql.h \
+    $$PWD/tablemetrics.h \
+    $$PWD/tablemodel.h
+
+# the migrations
+RESOURCES += $$PWD/res.qrc